@@ -1,10 +1,45 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <cstring>
 #include <cctype>
+#include <cstdlib>
+#include <cmath>
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <stdexcept>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SAT_TT_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define SAT_TT_X86_KERNELS 0
+#endif
+
+#if defined(__x86_64__) && defined(__linux__)
+#define SAT_TT_JIT 1
+#else
+#define SAT_TT_JIT 0
+#endif
 
 using namespace std ;
 
@@ -20,6 +55,102 @@ string binOpToString(BinOp op)
     }
 }
 
+// gives each distinct atom name a dense id 0, 1, 2, ... in order of first use.
+// lookups take a pointer and length, so names can be matched in place in the
+// input buffer; only the first occurrence of a name is copied
+class SymbolTable
+{
+public :
+    int intern (const string& name) {
+        return intern(name.data(), name.size()) ;
+    }
+
+    int intern (const char* s, size_t n) {
+        if (2 * (names.size() + 1) > table.size()) {
+            grow() ;
+        }
+        size_t mask = table.size() - 1 ;
+        for (size_t i = hash(s, n) & mask; ; i = (i + 1) & mask) {
+            int id = table[i] ;
+            if (id < 0) {
+                id = (int) names.size() ;
+                names.push_back(string(s, n)) ;
+                table[i] = id ;
+                return id ;
+            }
+            if (names[id].size() == n && memcmp(names[id].data(), s, n) == 0) {
+                return id ;
+            }
+        }
+    }
+
+    // -1 if the name was never interned
+    int find (const string& name) const {
+        if (table.empty()) {
+            return -1 ;
+        }
+        size_t mask = table.size() - 1 ;
+        for (size_t i = hash(name.data(), name.size()) & mask; ; i = (i + 1) & mask) {
+            int id = table[i] ;
+            if (id < 0 || names[id] == name) {
+                return id ;
+            }
+        }
+    }
+
+    const string& name (int id) const {
+        return names[id] ;
+    }
+
+    size_t size () const {
+        return names.size() ;
+    }
+
+private :
+    vector<string> names ;
+    vector<int> table ; // open-addressing index into names, -1 if empty
+
+    // FNV-1a
+    static size_t hash (const char* s, size_t n) {
+        uint64_t h = 0xcbf29ce484222325ULL ;
+        for (size_t i = 0; i < n; i++) {
+            h = (h ^ (unsigned char) s[i]) * 0x100000001b3ULL ;
+        }
+        return (size_t) h ;
+    }
+
+    void grow () {
+        table.assign(max<size_t>(16, 2 * table.size()), -1) ;
+        size_t mask = table.size() - 1 ;
+        for (size_t id = 0; id < names.size(); id++) {
+            size_t i = hash(names[id].data(), names[id].size()) & mask ;
+            while (table[i] >= 0) {
+                i = (i + 1) & mask ;
+            }
+            table[i] = (int) id ;
+        }
+    }
+} ;
+
+void checkAtomName (const char* name, size_t n)
+{
+    if (n == 0 || !isalpha((unsigned char) name[0])) {
+        throw invalid_argument("Atom name must start with a letter.") ;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!isalnum((unsigned char) name[i])) {
+            throw invalid_argument("Atom name must be alphanumeric.") ;
+        }
+    }
+}
+
+void checkAtomName (const string& name)
+{
+    checkAtomName(name.data(), name.size()) ;
+}
+
+// formulas can also be put together by hand from these classes and copied
+// into a FormulaStore with FormulaStore::intern
 class Formula
 {
 public:
@@ -33,14 +164,7 @@ public :
     string name ;
     
     Atom (const string& name) {
-        if (name.empty() || !isalpha(name[0])) {
-            throw invalid_argument("Atom name must start with a letter.") ;
-        }
-        for (char ch : name) {
-            if (!isalnum(ch)) {
-                throw invalid_argument("Atom name must be alphanumeric.") ;
-            }
-        }
+        checkAtomName(name) ;
         this->name = name ;
     }
     
@@ -89,8 +213,434 @@ public :
     }
 } ;
 
+enum class NodeKind : int32_t { Atom, Const, Neg, And, Or, Imp } ;
+
+NodeKind binOpKind (BinOp op)
+{
+    switch (op) {
+        case BinOp::And: return NodeKind::And ;
+        case BinOp::Or: return NodeKind::Or ;
+        case BinOp::Imp: return NodeKind::Imp ;
+    }
+    throw runtime_error("Unknown binary operator.") ;
+}
+
+BinOp kindBinOp (NodeKind kind)
+{
+    switch (kind) {
+        case NodeKind::And: return BinOp::And ;
+        case NodeKind::Or: return BinOp::Or ;
+        case NodeKind::Imp: return BinOp::Imp ;
+        default: throw runtime_error("Not a binary node.") ;
+    }
+}
+
+// a is the atom id, the constant's value or the (left) child, b the right child
+struct Node
+{
+    NodeKind kind ;
+    int32_t a ;
+    int32_t b ;
+} ;
+
+typedef int32_t NodeId ;
+
+// arena of tagged formula nodes. the store is also a hash-consing factory:
+// structurally identical subformulas get one canonical NodeId, so formulas
+// are kept as a DAG. nodes are only ever appended and children are made
+// before their parents, so ids are in topological order. everything the
+// store holds is released at once by clear() or its destructor
+class FormulaStore
+{
+public :
+    SymbolTable symbols ;
+
+    NodeId atom (const string& name) {
+        return atom(name.data(), name.size()) ;
+    }
+
+    NodeId atom (const char* name, size_t n) {
+        checkAtomName(name, n) ;
+        return make(NodeKind::Atom, symbols.intern(name, n), 0) ;
+    }
+
+    NodeId constant (bool value) {
+        return make(NodeKind::Const, value ? 1 : 0, 0) ;
+    }
+
+    NodeId neg (NodeId operand) {
+        return make(NodeKind::Neg, operand, 0) ;
+    }
+
+    NodeId bin (BinOp op, NodeId left, NodeId right) {
+        return make(binOpKind(op), left, right) ;
+    }
+
+    // copies a tree built from the Formula classes into the store
+    NodeId intern (const shared_ptr<Formula>& f) {
+        unordered_map<const Formula*, NodeId> done ;
+        return intern(f, done) ;
+    }
+
+    const Node& operator[] (NodeId id) const {
+        return nodes[id] ;
+    }
+
+    size_t size () const {
+        return nodes.size() ;
+    }
+
+    void clear () {
+        vector<Node>().swap(nodes) ;
+        vector<NodeId>().swap(table) ;
+        symbols = SymbolTable() ;
+    }
+
+    // live[id] is set for every node reachable from root
+    vector<bool> reachable (NodeId root) const {
+        vector<bool> live(root + 1) ;
+        live[root] = true ;
+        for (NodeId id = root; id >= 0; id--) {
+            if (!live[id]) {
+                continue ;
+            }
+            const Node& n = nodes[id] ;
+            if (n.kind == NodeKind::Neg) {
+                live[n.a] = true ;
+            } else if (n.kind != NodeKind::Atom && n.kind != NodeKind::Const) {
+                live[n.a] = true ;
+                live[n.b] = true ;
+            }
+        }
+        return live ;
+    }
+
+    // same text as Formula::to_string, printed with an explicit stack;
+    // stage counts the children of the top node already printed
+    string to_string (NodeId root) const {
+        string out ;
+        vector<pair<NodeId, int> > stack(1, make_pair(root, 0)) ;
+        while (!stack.empty()) {
+            NodeId id = stack.back().first ;
+            int stage = stack.back().second++ ;
+            const Node& n = nodes[id] ;
+            switch (n.kind) {
+                case NodeKind::Atom:
+                    out += symbols.name(n.a) ;
+                    stack.pop_back() ;
+                    break ;
+                case NodeKind::Const:
+                    out += n.a ? "true" : "false" ;
+                    stack.pop_back() ;
+                    break ;
+                case NodeKind::Neg:
+                    if (stage == 0) {
+                        out += "!(" ;
+                        stack.push_back(make_pair(n.a, 0)) ;
+                    } else {
+                        out += ")" ;
+                        stack.pop_back() ;
+                    }
+                    break ;
+                default:
+                    if (stage == 0) {
+                        out += "(" ;
+                        stack.push_back(make_pair(n.a, 0)) ;
+                    } else if (stage == 1) {
+                        out += " " + binOpToString(kindBinOp(n.kind)) + " " ;
+                        stack.push_back(make_pair(n.b, 0)) ;
+                    } else {
+                        out += ")" ;
+                        stack.pop_back() ;
+                    }
+                    break ;
+            }
+        }
+        return out ;
+    }
+
+    // the pAnd(pAtom("p"), ...) input syntax, so the text parses back to root
+    string to_source (NodeId root) const {
+        static const char* const names[] = { "pAtom", "pConst", "pNeg", "pAnd", "pOr", "pImp" } ;
+        string out ;
+        vector<pair<NodeId, int> > stack(1, make_pair(root, 0)) ;
+        while (!stack.empty()) {
+            NodeId id = stack.back().first ;
+            int stage = stack.back().second++ ;
+            const Node& n = nodes[id] ;
+            int arity = n.kind == NodeKind::Neg ? 1 : n.kind == NodeKind::Atom || n.kind == NodeKind::Const ? 0 : 2 ;
+            if (stage == 0) {
+                out += names[(int) n.kind] ;
+                out += "(" ;
+                if (n.kind == NodeKind::Atom) {
+                    out += "\"" + symbols.name(n.a) + "\"" ;
+                } else if (n.kind == NodeKind::Const) {
+                    out += n.a ? "\"true\"" : "\"false\"" ;
+                }
+            }
+            if (stage < arity) {
+                if (stage > 0) {
+                    out += ", " ;
+                }
+                stack.push_back(make_pair(stage == 0 ? n.a : n.b, 0)) ;
+            } else {
+                out += ")" ;
+                stack.pop_back() ;
+            }
+        }
+        return out ;
+    }
+
+private :
+    vector<Node> nodes ;
+    vector<NodeId> table ; // open-addressing unique table of node ids, -1 if empty
+
+    static size_t hash (const Node& n) {
+        uint64_t h = ((uint64_t) (uint32_t) n.a << 32 | (uint32_t) n.b) * 0x9E3779B97F4A7C15ULL ;
+        return (size_t) (h ^ (h >> 29) ^ (uint64_t) n.kind) ;
+    }
+
+    static bool same (const Node& x, const Node& y) {
+        return x.kind == y.kind && x.a == y.a && x.b == y.b ;
+    }
+
+    NodeId make (NodeKind kind, int32_t a, int32_t b) {
+        Node n = { kind, a, b } ;
+        if (2 * (nodes.size() + 1) > table.size()) {
+            grow() ;
+        }
+        size_t mask = table.size() - 1 ;
+        for (size_t i = hash(n) & mask; ; i = (i + 1) & mask) {
+            NodeId id = table[i] ;
+            if (id < 0) {
+                id = (NodeId) nodes.size() ;
+                nodes.push_back(n) ;
+                table[i] = id ;
+                return id ;
+            }
+            if (same(nodes[id], n)) {
+                return id ;
+            }
+        }
+    }
+
+    void grow () {
+        table.assign(max<size_t>(16, 2 * table.size()), -1) ;
+        size_t mask = table.size() - 1 ;
+        for (size_t id = 0; id < nodes.size(); id++) {
+            size_t i = hash(nodes[id]) & mask ;
+            while (table[i] >= 0) {
+                i = (i + 1) & mask ;
+            }
+            table[i] = (NodeId) id ;
+        }
+    }
+
+    // done also shares subtrees that are the same shared_ptr, so a tree
+    // built with heavy pointer sharing is walked once per distinct object.
+    // a node stays on the stack until its operands are interned
+    NodeId intern (const shared_ptr<Formula>& f, unordered_map<const Formula*, NodeId>& done) {
+        vector<const Formula*> stack(1, f.get()) ;
+        while (!stack.empty()) {
+            const Formula* cur = stack.back() ;
+            if (done.count(cur)) {
+                stack.pop_back() ;
+            } else if (auto atom = dynamic_cast<const Atom*>(cur)) {
+                done[cur] = this->atom(atom->name) ;
+                stack.pop_back() ;
+            } else if (auto c = dynamic_cast<const Const*>(cur)) {
+                done[cur] = constant(c->value) ;
+                stack.pop_back() ;
+            } else if (auto n = dynamic_cast<const Neg*>(cur)) {
+                auto operand = done.find(n->operand.get()) ;
+                if (operand == done.end()) {
+                    stack.push_back(n->operand.get()) ;
+                } else {
+                    done[cur] = neg(operand->second) ;
+                    stack.pop_back() ;
+                }
+            } else if (auto b = dynamic_cast<const BinFormula*>(cur)) {
+                auto left = done.find(b->left.get()) ;
+                auto right = done.find(b->right.get()) ;
+                if (left == done.end() || right == done.end()) {
+                    if (right == done.end()) {
+                        stack.push_back(b->right.get()) ;
+                    }
+                    if (left == done.end()) {
+                        stack.push_back(b->left.get()) ;
+                    }
+                } else {
+                    done[cur] = bin(b->op, left->second, right->second) ;
+                    stack.pop_back() ;
+                }
+            } else {
+                throw runtime_error("Unknown formula type.") ;
+            }
+        }
+        return done[f.get()] ;
+    }
+} ;
+
+long peakRssKb ()
+{
+    struct rusage usage ;
+    getrusage(RUSAGE_SELF, &usage) ;
+    return usage.ru_maxrss ;
+}
+
+// process-wide instrumentation, off unless enable() is called. while off a
+// hook costs one relaxed load: ProfileScope skips the clock and count()
+// skips the add. hot loops keep local tallies and report them once per
+// call. bit-sliced backends visit a node once per 64-assignment word, so
+// their node visits per assignment come out as a fraction
+class Profiler
+{
+public :
+    enum Counter { Assignments, NodeVisits, Conflicts, NumCounters } ;
+    typedef chrono::steady_clock Clock ;
+
+    static Profiler& global ()
+    {
+        static Profiler instance ;
+        return instance ;
+    }
+
+    // keepEvents stores every timed scope for a Chrome trace, otherwise
+    // only per-phase totals are kept
+    void enable (bool keepEvents)
+    {
+        lock_guard<mutex> guard(lock) ;
+        epoch = Clock::now() ;
+        this->keepEvents = keepEvents ;
+        on.store(true, memory_order_relaxed) ;
+    }
+
+    bool enabled () const
+    {
+        return on.load(memory_order_relaxed) ;
+    }
+
+    void count (Counter counter, uint64_t n)
+    {
+        if (enabled()) {
+            counters[counter].fetch_add(n, memory_order_relaxed) ;
+        }
+    }
+
+    void record (const char* phase, Clock::time_point start, Clock::time_point end)
+    {
+        lock_guard<mutex> guard(lock) ;
+        uint64_t ns = (uint64_t) chrono::duration_cast<chrono::nanoseconds>(end - start).count() ;
+        Totals& totals = phases[phase] ;
+        totals.calls++ ;
+        totals.ns += ns ;
+        if (keepEvents) {
+            uint64_t offset = (uint64_t) chrono::duration_cast<chrono::nanoseconds>(start - epoch).count() ;
+            Event event = { phase, offset, ns, threadIndex() } ;
+            events.push_back(event) ;
+        }
+    }
+
+    // {"phases": {name: {"calls", "total_ns"}}, "counters": {...}, "peak_rss_kb"}
+    void writeJson (ostream& out)
+    {
+        lock_guard<mutex> guard(lock) ;
+        out << "{\"phases\": {" ;
+        const char* separator = "" ;
+        for (const auto& phase : phases) {
+            out << separator << "\"" << phase.first << "\": {\"calls\": " << phase.second.calls
+                << ", \"total_ns\": " << phase.second.ns << "}" ;
+            separator = ", " ;
+        }
+        uint64_t assignments = counters[Assignments] ;
+        uint64_t visits = counters[NodeVisits] ;
+        out << "}, \"counters\": {\"assignments\": " << assignments << ", \"node_visits\": " << visits
+            << ", \"node_visits_per_assignment\": " << (assignments ? (double) visits / assignments : 0.0)
+            << ", \"conflicts\": " << counters[Conflicts] << "}, \"peak_rss_kb\": " << peakRssKb() << "}" << endl ;
+    }
+
+    // Chrome trace event format: one complete ("X") event per timed scope,
+    // in microseconds, and the counters as one counter ("C") event at the end.
+    // times keep their nanoseconds, fixed-point, however long the run
+    void writeTrace (ostream& out)
+    {
+        lock_guard<mutex> guard(lock) ;
+        ios::fmtflags flags = out.flags() ;
+        streamsize precision = out.precision() ;
+        out << fixed << setprecision(3) ;
+        out << "{\"traceEvents\": [" ;
+        uint64_t last = 0 ;
+        for (const Event& event : events) {
+            out << "\n  {\"name\": \"" << event.phase << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+                << ", \"ts\": " << event.start / 1000.0 << ", \"dur\": " << event.ns / 1000.0 << "}," ;
+            last = max(last, event.start + event.ns) ;
+        }
+        out << "\n  {\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"tid\": 0, \"ts\": " << last / 1000.0
+            << ", \"args\": {\"assignments\": " << counters[Assignments] << ", \"node_visits\": " << counters[NodeVisits]
+            << ", \"conflicts\": " << counters[Conflicts] << ", \"peak_rss_kb\": " << peakRssKb() << "}}\n]}" << endl ;
+        out.flags(flags) ;
+        out.precision(precision) ;
+    }
+
+private :
+    struct Totals {
+        uint64_t calls = 0 ;
+        uint64_t ns = 0 ;
+    } ;
+
+    struct Event {
+        const char* phase ;
+        uint64_t start ; // ns since enable()
+        uint64_t ns ;
+        unsigned thread ;
+    } ;
+
+    atomic<bool> on { false } ;
+    atomic<uint64_t> counters[NumCounters] = {} ;
+    mutex lock ;
+    bool keepEvents = false ;
+    Clock::time_point epoch ;
+    map<string, Totals> phases ;
+    vector<Event> events ;
+
+    // small per-thread numbers for the trace viewer, in order of first event
+    static unsigned threadIndex ()
+    {
+        static atomic<unsigned> next(0) ;
+        thread_local unsigned index = next++ ;
+        return index ;
+    }
+} ;
+
+// times the enclosing block as one phase while the profiler is on
+class ProfileScope
+{
+public :
+    explicit ProfileScope (const char* phase) : phase(phase), active(Profiler::global().enabled()) {
+        if (active) {
+            start = Profiler::Clock::now() ;
+        }
+    }
+
+    ~ProfileScope ()
+    {
+        if (active) {
+            Profiler::global().record(phase, start, Profiler::Clock::now()) ;
+        }
+    }
+
+    ProfileScope (const ProfileScope&) = delete ;
+    ProfileScope& operator= (const ProfileScope&) = delete ;
+
+private :
+    const char* phase ;
+    bool active ;
+    Profiler::Clock::time_point start ;
+} ;
+
 vector<string> tokenize (const string& input)
 {
+    ProfileScope scope("tokenize") ;
     vector<string> tokens ;
     string current ;
     bool in_quotes = false ;
@@ -135,33 +685,72 @@ vector<string> tokenize (const string& input)
 class FormulaBuilder 
 {
 public:
-    FormulaBuilder (const vector<string>& tokens) : tokens(tokens), pos(0) {}
+    FormulaBuilder (const vector<string>& tokens, FormulaStore& store) : tokens(tokens), pos(0), store(store) {}
 
-    shared_ptr<Formula> buildFormula () {
-        if (pos >= tokens.size()) {
-            throw runtime_error("Unexpected end of input") ;
-        }
+    // keeps the open pNeg/pAnd/pOr/pImp calls on an explicit stack, so the
+    // nesting depth is limited by memory rather than by the native stack
+    NodeId buildFormula () {
+        vector<OpenCall> open ;
+        for (;;) {
+            NodeId result = -1 ;
+            while (result < 0) {
+                if (pos >= tokens.size()) {
+                    throw runtime_error("Unexpected end of input") ;
+                }
 
-        string token = tokens[pos] ;
+                const string& token = tokens[pos] ;
 
-        if (token == "pAtom") {
-            return pAtom() ;
-        } else if (token == "pConst") {
-            return pConst() ;
-        } else if (token == "pNeg") {
-            return pNeg() ;
-        } else if (token == "pAnd" || token == "pOr" || token == "pImp") {
-            return pBinFormula(token) ;
-        } else {
-            throw runtime_error("Unexpected token: " + token) ;
+                if (token == "pAtom") {
+                    result = pAtom() ;
+                } else if (token == "pConst") {
+                    result = pConst() ;
+                } else if (token == "pNeg" || token == "pAnd" || token == "pOr" || token == "pImp") {
+                    OpenCall call = { callKind(token), -1 } ;
+                    expect(token) ;
+                    expect("(") ;
+                    open.push_back(call) ;
+                } else {
+                    throw runtime_error("Unexpected token: " + token) ;
+                }
+            }
+
+            // close every call that this operand completes
+            for (;;) {
+                if (open.empty()) {
+                    return result ;
+                }
+                OpenCall& call = open.back() ;
+                if (call.kind != NodeKind::Neg && call.left < 0) {
+                    call.left = result ;
+                    expect(",") ;
+                    break ;
+                }
+                expect(")") ;
+                result = call.kind == NodeKind::Neg ? store.neg(result) : store.bin(kindBinOp(call.kind), call.left, result) ;
+                open.pop_back() ;
+            }
         }
     }
 
 private:
+    // a call whose closing parenthesis has not been read yet
+    struct OpenCall {
+        NodeKind kind ;
+        NodeId left ; // first operand of a binary call once it is parsed
+    } ;
+
     const vector<string>& tokens ;
     size_t pos ;
+    FormulaStore& store ;
+
+    static NodeKind callKind (const string& token) {
+        if (token == "pNeg") return NodeKind::Neg ;
+        if (token == "pAnd") return NodeKind::And ;
+        if (token == "pOr") return NodeKind::Or ;
+        return NodeKind::Imp ;
+    }
      
-    string consume () {
+    const string& consume () {
         if (pos >= tokens.size()) {
             throw runtime_error("Out of tokens") ;
         }
@@ -174,192 +763,4744 @@ private:
         }
     }
 
-    shared_ptr<Formula> pAtom () {
+    NodeId pAtom () {
         expect("pAtom") ;
         expect("(") ;
         string name = consume() ;
         expect(")") ;
-        return make_shared<Atom>(name.substr(1, name.size() - 2)) ;
+        return store.atom(name.substr(1, name.size() - 2)) ;
     }
 
-    shared_ptr<Formula> pConst () {
+    NodeId pConst () {
         expect("pConst") ;
         expect("(") ;
-        string val = consume() ;
-        expect(")") ;
-        return make_shared<Const>(val == "\"true\"") ;
-    }
-
-    shared_ptr<Formula> pNeg () {
-        expect("pNeg") ;
-        expect("(") ;
-        auto operand = buildFormula() ;
+        bool value = consume() == "\"true\"" ;
         expect(")") ;
-        return make_shared<Neg>(operand) ;
+        return store.constant(value) ;
     }
 
-    shared_ptr<Formula> pBinFormula (const string& opToken) {
-        BinOp op ;
-        if (opToken == "pAnd") op = BinOp::And ;
-        if (opToken == "pOr") op = BinOp::Or ;
-        if (opToken == "pImp") op = BinOp::Imp ;
-
-        expect(opToken) ;
-        expect("(") ;
-        auto left = buildFormula() ;
-        expect(",") ;
-        auto right = buildFormula() ;
-        expect(")") ;
-        return make_shared<BinFormula>(op, left, right) ;
-    }
 } ;
 
-shared_ptr<Formula> buildFromTokens (const vector<string>& tokens) 
+// nodes are allocated in store; the returned id is the root
+NodeId buildFromTokens (const vector<string>& tokens, FormulaStore& store) 
 {
-    FormulaBuilder builder(tokens) ;
+    ProfileScope scope("buildFromTokens") ;
+    FormulaBuilder builder(tokens, store) ;
     return builder.buildFormula() ;
 }
 
-void collectAtoms (shared_ptr<Formula> f, set<string>& result) 
-{
-    if (auto atom = dynamic_pointer_cast<Atom>(f)) {
-        result.insert(atom->name) ;
-    } else if (auto constant = dynamic_pointer_cast<Const>(f)) {
-        // do nothing
-    } else if (auto neg = dynamic_pointer_cast<Neg>(f)) {
-        collectAtoms(neg->operand, result) ;
-    } else if (auto bin = dynamic_pointer_cast<BinFormula>(f)) {
-        collectAtoms(bin->left, result) ;
-        collectAtoms(bin->right, result) ;
-    }
-}
-
-set<string> getAllAtomicProps (shared_ptr<Formula> formula) 
-{
-    set<string> result ;
-    collectAtoms(formula, result) ;
-    return result ;   
-}
-
-class FormulaInterpreter 
+// single-pass parser for the pAnd(...)/pAtom("p") syntax that reads straight
+// from a character buffer, e.g. a string or an mmap'd file. it builds no
+// token vector and matches keywords and atom names in place, so the only
+// allocations are store nodes and the first copy of each atom name
+class StreamParser
 {
 public :
-    FormulaInterpreter(shared_ptr<Formula> formula) : formula(formula) {
-        set<string> atomSet = getAllAtomicProps(formula) ;
-        atoms.assign(atomSet.begin(), atomSet.end()) ;
-    }
+    StreamParser (const char* begin, const char* end, FormulaStore& store) : cur(begin), end(end), store(store) {}
 
-    bool isSatisfiable ()
-    {
-        map<string, bool> assignment ;
-        return tryAssignments(0, assignment) ;
-    }
-
-    bool isValid ()
-    {
-        map<string, bool> assignment ;
-        return tryAllAssignmentsForValidity(0, assignment) ;
+    NodeId parse () {
+        NodeId root = formula() ;
+        skipSpace() ;
+        if (cur != end) {
+            throw runtime_error("Unexpected input after formula") ;
+        }
+        return root ;
     }
 
 private :
-    shared_ptr<Formula> formula ;
-    vector<string> atoms ;
+    const char* cur ;
+    const char* end ;
+    FormulaStore& store ;
 
-    bool evaluate (const shared_ptr<Formula> &formula, const map<string, bool>& assignment) 
-    {
-        if (auto atom = dynamic_pointer_cast<Atom>(formula)) {
-            auto it = assignment.find(atom->name) ;
-            if (it == assignment.end()) {
-                throw runtime_error("Unassigned variable: " + atom->name) ;
-            }
-            return it->second ;
-        } else if (auto constant = dynamic_pointer_cast<Const>(formula)) {
-            return constant->value ;
-        } else if (auto neg = dynamic_pointer_cast<Neg>(formula)) {
-            return !evaluate(neg->operand, assignment) ;
-        } else if (auto bin = dynamic_pointer_cast<BinFormula>(formula)) {
-            bool left = evaluate(bin->left, assignment) ;
-            bool right = evaluate(bin->right, assignment) ;
-            
-            switch (bin->op) {
-                case BinOp::And: return left && right ;
-                case BinOp::Or: return left || right ;
-                case BinOp::Imp: return !left || right ;
-            }
+    void skipSpace () {
+        while (cur != end && isspace((unsigned char) *cur)) {
+            cur++ ;
         }
+    }
 
-        throw runtime_error("Unknown formula type.") ;
-    } 
-
-    bool tryAssignments (int index, map<string, bool>& assignment)
-    {
-        if (index == atoms.size()) {
-            return evaluate(formula, assignment) ;
+    // a word runs up to the next space, quote, parenthesis or comma, like a token of tokenize()
+    size_t word (const char*& start) {
+        skipSpace() ;
+        start = cur ;
+        while (cur != end && !isspace((unsigned char) *cur) && *cur != '"' && *cur != '(' && *cur != ')' && *cur != ',') {
+            cur++ ;
         }
+        return cur - start ;
+    }
 
-        string atom = atoms[index] ;
-
-        assignment[atom] = false ;
-        if (tryAssignments(index + 1, assignment)) {
-            return true ;
+    // contents of a "..." string, without the quotes
+    size_t quoted (const char*& start) {
+        expect('"') ;
+        start = cur ;
+        while (cur != end && *cur != '"') {
+            cur++ ;
         }
-
-        assignment[atom] = true ;
-        if (tryAssignments(index + 1, assignment)) {
-            return true ;
+        if (cur == end) {
+            throw runtime_error("Unterminated string") ;
         }
-
-        return false ;
+        return cur++ - start ;
     }
 
-    bool tryAllAssignmentsForValidity (int index, map<string, bool>& assignment) 
-    {
-        if (index == atoms.size()) {
-            return evaluate(formula, assignment) ;
+    void expect (char ch) {
+        skipSpace() ;
+        if (cur == end || *cur != ch) {
+            throw runtime_error(string("Expected '") + ch + "'") ;
         }
+        cur++ ;
+    }
 
-        const string& atom = atoms[index] ;
+    static bool is (const char* w, size_t n, const char* keyword) {
+        return n == strlen(keyword) && memcmp(w, keyword, n) == 0 ;
+    }
 
-        assignment[atom] = false ;
-        if (!tryAllAssignmentsForValidity(index + 1, assignment)) {
-            return false ;
-        }
+    // a call whose closing parenthesis has not been read yet
+    struct OpenCall {
+        NodeKind kind ;
+        NodeId left ;
+    } ;
 
-        assignment[atom] = true ;
-        if (!tryAllAssignmentsForValidity(index + 1, assignment)) {
-            return false ;
-        } 
+    // same explicit-stack scheme as FormulaBuilder::buildFormula
+    NodeId formula () {
+        vector<OpenCall> open ;
+        for (;;) {
+            NodeId result = -1 ;
+            while (result < 0) {
+                const char* w ;
+                size_t n = word(w) ;
+                if (n == 0) {
+                    if (cur == end) {
+                        throw runtime_error("Unexpected end of input") ;
+                    }
+                    throw runtime_error(string("Unexpected token: ") + *cur) ;
+                }
 
-        return true ;
+                if (is(w, n, "pAtom")) {
+                    expect('(') ;
+                    const char* name ;
+                    size_t len = quoted(name) ;
+                    expect(')') ;
+                    result = store.atom(name, len) ;
+                } else if (is(w, n, "pConst")) {
+                    expect('(') ;
+                    const char* value ;
+                    size_t len = quoted(value) ;
+                    expect(')') ;
+                    result = store.constant(is(value, len, "true")) ;
+                } else {
+                    OpenCall call = { NodeKind::Neg, -1 } ;
+                    if (is(w, n, "pAnd")) {
+                        call.kind = NodeKind::And ;
+                    } else if (is(w, n, "pOr")) {
+                        call.kind = NodeKind::Or ;
+                    } else if (is(w, n, "pImp")) {
+                        call.kind = NodeKind::Imp ;
+                    } else if (!is(w, n, "pNeg")) {
+                        throw runtime_error("Unexpected token: " + string(w, n)) ;
+                    }
+                    expect('(') ;
+                    open.push_back(call) ;
+                }
+            }
+
+            for (;;) {
+                if (open.empty()) {
+                    return result ;
+                }
+                OpenCall& call = open.back() ;
+                if (call.kind != NodeKind::Neg && call.left < 0) {
+                    call.left = result ;
+                    expect(',') ;
+                    break ;
+                }
+                expect(')') ;
+                result = call.kind == NodeKind::Neg ? store.neg(result) : store.bin(kindBinOp(call.kind), call.left, result) ;
+                open.pop_back() ;
+            }
+        }
     }
 } ;
 
-int main ()
+NodeId parseFormula (const string& input, FormulaStore& store)
 {
-    // this is the input
-    string input = R"(pAnd(pAtom("p"), pOr(pAtom("q"), pNeg(pOr(pNeg(pAtom("r")), pConst("true"))))))" ;
-    
-    // get formula from the AST object
-    vector<string> tokens = tokenize(input) ;
-    auto formula = buildFromTokens(tokens) ;
-    cout << "Parsed formula: " << formula->to_string() << endl ;
+    ProfileScope scope("parse") ;
+    return StreamParser(input.data(), input.data() + input.size(), store).parse() ;
+}
 
-    // get the set of atomic propositions from the formula 
-    set<string> atomSet = getAllAtomicProps(formula) ;    
-    cout << "Atoms: { " ;
-    for (const string& atom : atomSet) {
-        cout << atom << " " ;
-    }
-    cout << "}" << endl ;
+// binary formula files hold the nodes reachable from the root, renumbered
+// so children come first and the root is last, and the atom names, so
+// loading is a bulk pass over fixed-size records with no text to scan.
+// all fields are little-endian 32-bit words:
+//     "SATTTBF1" nodeCount atomCount nameBytes
+//     nodeCount x { kind a b }       kind as NodeKind, a an atom index for atoms
+//     (atomCount + 1) x nameOffset   into the name bytes
+//     nameBytes bytes of atom names, not terminated
+static const char kBinaryMagic[8] = { 'S', 'A', 'T', 'T', 'T', 'B', 'F', '1' } ;
 
-    // truth-table
-    FormulaInterpreter interpreter(formula) ;
+struct BinaryHeader
+{
+    char magic[8] ;
+    uint32_t nodeCount ;
+    uint32_t atomCount ;
+    uint32_t nameBytes ;
+} ;
 
-    bool satisfiable = interpreter.isSatisfiable() ;
-    cout << "Formula is " << (satisfiable ? "satisfiable" : "unsatisfiable") << endl ;
+struct BinaryNode
+{
+    uint32_t kind ;
+    int32_t a ;
+    int32_t b ;
+} ;
 
-    bool valid = interpreter.isValid() ;
-    cout << "Formula is " << (valid ? "valid" : "not valid") << endl ;
+bool isBinaryFormula (const char* data, size_t size)
+{
+    return size >= sizeof(kBinaryMagic) && memcmp(data, kBinaryMagic, sizeof(kBinaryMagic)) == 0 ;
+}
 
-    return 0 ;
-}
\ No newline at end of file
+void writeBinary (ostream& out, const FormulaStore& store, NodeId root)
+{
+    vector<bool> live = store.reachable(root) ;
+    vector<int32_t> index(root + 1, -1) ;
+    vector<int32_t> atomIndex(store.symbols.size(), -1) ;
+    vector<BinaryNode> nodes ;
+    vector<uint32_t> offsets(1, 0) ;
+    string names ;
+
+    for (NodeId id = 0; id <= root; id++) {
+        if (!live[id]) {
+            continue ;
+        }
+        const Node& n = store[id] ;
+        BinaryNode record = { (uint32_t) n.kind, n.a, n.b } ;
+        if (n.kind == NodeKind::Atom) {
+            if (atomIndex[n.a] < 0) {
+                atomIndex[n.a] = (int32_t) offsets.size() - 1 ;
+                names += store.symbols.name(n.a) ;
+                offsets.push_back((uint32_t) names.size()) ;
+            }
+            record.a = atomIndex[n.a] ;
+        } else if (n.kind == NodeKind::Neg) {
+            record.a = index[n.a] ;
+        } else if (n.kind != NodeKind::Const) {
+            record.a = index[n.a] ;
+            record.b = index[n.b] ;
+        }
+        index[id] = (int32_t) nodes.size() ;
+        nodes.push_back(record) ;
+    }
+
+    BinaryHeader header ;
+    memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) ;
+    header.nodeCount = (uint32_t) nodes.size() ;
+    header.atomCount = (uint32_t) offsets.size() - 1 ;
+    header.nameBytes = (uint32_t) names.size() ;
+    out.write((const char*) &header, sizeof(header)) ;
+    out.write((const char*) nodes.data(), nodes.size() * sizeof(BinaryNode)) ;
+    out.write((const char*) offsets.data(), offsets.size() * sizeof(uint32_t)) ;
+    out.write(names.data(), names.size()) ;
+}
+
+// interns the nodes of a binary formula into store and returns its root.
+// every record is checked before use, so a truncated or corrupt file is an
+// error rather than an out-of-bounds read
+NodeId readBinary (const char* data, size_t size, FormulaStore& store)
+{
+    BinaryHeader header ;
+    if (!isBinaryFormula(data, size) || size < sizeof(header)) {
+        throw runtime_error("Not a binary formula file") ;
+    }
+    memcpy(&header, data, sizeof(header)) ;
+    uint64_t nodeBytes = (uint64_t) header.nodeCount * sizeof(BinaryNode) ;
+    uint64_t offsetBytes = ((uint64_t) header.atomCount + 1) * sizeof(uint32_t) ;
+    if (header.nodeCount == 0 || sizeof(header) + nodeBytes + offsetBytes + header.nameBytes != size) {
+        throw runtime_error("Binary formula file has the wrong size") ;
+    }
+    const char* nodeData = data + sizeof(header) ;
+    const char* offsetData = nodeData + nodeBytes ;
+    const char* names = offsetData + offsetBytes ;
+
+    vector<NodeId> atoms(header.atomCount) ;
+    uint32_t previous = 0 ;
+    for (uint32_t i = 0; i <= header.atomCount; i++) {
+        uint32_t offset ;
+        memcpy(&offset, offsetData + i * sizeof(uint32_t), sizeof(offset)) ;
+        if (offset < previous || offset > header.nameBytes || (i == 0 && offset != 0)) {
+            throw runtime_error("Binary formula file has a bad name table") ;
+        }
+        if (i > 0) {
+            atoms[i - 1] = store.atom(names + previous, offset - previous) ;
+        }
+        previous = offset ;
+    }
+
+    vector<NodeId> ids(header.nodeCount) ;
+    for (uint32_t i = 0; i < header.nodeCount; i++) {
+        BinaryNode n ;
+        memcpy(&n, nodeData + i * sizeof(BinaryNode), sizeof(n)) ;
+        bool childrenOk = n.a >= 0 && (uint32_t) n.a < i
+            && (n.kind == (uint32_t) NodeKind::Neg || (n.b >= 0 && (uint32_t) n.b < i)) ;
+        switch ((NodeKind) n.kind) {
+            case NodeKind::Atom:
+                if (n.a < 0 || (uint32_t) n.a >= header.atomCount) {
+                    throw runtime_error("Binary formula file has a bad atom index") ;
+                }
+                ids[i] = atoms[n.a] ;
+                continue ;
+            case NodeKind::Const:
+                ids[i] = store.constant(n.a != 0) ;
+                continue ;
+            case NodeKind::Neg:
+            case NodeKind::And:
+            case NodeKind::Or:
+            case NodeKind::Imp:
+                if (!childrenOk) {
+                    throw runtime_error("Binary formula file has a bad child index") ;
+                }
+                break ;
+            default:
+                throw runtime_error("Binary formula file has a bad node kind") ;
+        }
+        if (n.kind == (uint32_t) NodeKind::Neg) {
+            ids[i] = store.neg(ids[n.a]) ;
+        } else {
+            ids[i] = store.bin(kindBinOp((NodeKind) n.kind), ids[n.a], ids[n.b]) ;
+        }
+    }
+    return ids.back() ;
+}
+
+// maps the file read-only and parses it in place, as the binary format
+// if it starts with the binary magic and as formula text otherwise
+NodeId parseFile (const string& path, FormulaStore& store)
+{
+    ProfileScope scope("parse") ;
+    int fd = open(path.c_str(), O_RDONLY) ;
+    if (fd < 0) {
+        throw runtime_error("Cannot open " + path) ;
+    }
+    struct stat st ;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd) ;
+        throw runtime_error("Cannot read " + path) ;
+    }
+    size_t size = (size_t) st.st_size ;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+    close(fd) ;
+    if (data == MAP_FAILED) {
+        throw runtime_error("Cannot map " + path) ;
+    }
+    madvise(data, size, MADV_SEQUENTIAL) ;
+
+    const char* text = (const char*) data ;
+    try {
+        NodeId root = isBinaryFormula(text, size) ? readBinary(text, size, store)
+                                                  : StreamParser(text, text + size, store).parse() ;
+        munmap(data, size) ;
+        return root ;
+    } catch (...) {
+        munmap(data, size) ;
+        throw ;
+    }
+}
+
+// rewrites a formula bottom-up into an equivalent, usually smaller one:
+// constants are folded through the connectives, double negations removed,
+// and idempotence (x & x), complements (x & !x) and absorption
+// (x & (x | y)) applied. rewritten nodes are appended to the store, so the
+// old root stays valid. atoms that only occurred in folded branches are
+// not reachable from the new root, so every one of them halves the
+// enumeration work
+class Simplifier
+{
+public :
+    explicit Simplifier (FormulaStore& store) : store(store) {}
+
+    NodeId run (NodeId root) {
+        vector<bool> live = store.reachable(root) ;
+        vector<NodeId> image(root + 1, -1) ;
+        for (NodeId id = 0; id <= root; id++) {
+            if (!live[id]) {
+                continue ;
+            }
+            Node n = store[id] ; // a copy, the store grows below
+            switch (n.kind) {
+                case NodeKind::Atom:
+                case NodeKind::Const:
+                    image[id] = id ;
+                    break ;
+                case NodeKind::Neg:
+                    image[id] = neg(image[n.a]) ;
+                    break ;
+                case NodeKind::And:
+                    image[id] = conj(image[n.a], image[n.b]) ;
+                    break ;
+                case NodeKind::Or:
+                    image[id] = disj(image[n.a], image[n.b]) ;
+                    break ;
+                case NodeKind::Imp:
+                    image[id] = imp(image[n.a], image[n.b]) ;
+                    break ;
+            }
+        }
+        return image[root] ;
+    }
+
+private :
+    FormulaStore& store ;
+
+    bool isConst (NodeId x, bool value) const {
+        return store[x].kind == NodeKind::Const && store[x].a == (value ? 1 : 0) ;
+    }
+
+    bool complementary (NodeId x, NodeId y) const {
+        return (store[x].kind == NodeKind::Neg && store[x].a == y)
+            || (store[y].kind == NodeKind::Neg && store[y].a == x) ;
+    }
+
+    // y is a `kind` node with x as one operand
+    bool hasOperand (NodeId y, NodeKind kind, NodeId x) const {
+        return store[y].kind == kind && (store[y].a == x || store[y].b == x) ;
+    }
+
+    NodeId neg (NodeId x) {
+        if (store[x].kind == NodeKind::Const) {
+            return store.constant(store[x].a == 0) ;
+        }
+        if (store[x].kind == NodeKind::Neg) {
+            return store[x].a ;
+        }
+        return store.neg(x) ;
+    }
+
+    NodeId conj (NodeId x, NodeId y) {
+        if (isConst(x, false) || isConst(y, false) || complementary(x, y)) {
+            return store.constant(false) ;
+        }
+        if (isConst(x, true) || hasOperand(x, NodeKind::Or, y)) {
+            return y ;
+        }
+        if (isConst(y, true) || x == y || hasOperand(y, NodeKind::Or, x)) {
+            return x ;
+        }
+        if (hasOperand(x, NodeKind::And, y)) { // (y & z) & y
+            return x ;
+        }
+        if (hasOperand(y, NodeKind::And, x)) {
+            return y ;
+        }
+        return store.bin(BinOp::And, x, y) ;
+    }
+
+    NodeId disj (NodeId x, NodeId y) {
+        if (isConst(x, true) || isConst(y, true) || complementary(x, y)) {
+            return store.constant(true) ;
+        }
+        if (isConst(x, false) || hasOperand(x, NodeKind::And, y)) {
+            return y ;
+        }
+        if (isConst(y, false) || x == y || hasOperand(y, NodeKind::And, x)) {
+            return x ;
+        }
+        if (hasOperand(x, NodeKind::Or, y)) {
+            return x ;
+        }
+        if (hasOperand(y, NodeKind::Or, x)) {
+            return y ;
+        }
+        return store.bin(BinOp::Or, x, y) ;
+    }
+
+    NodeId imp (NodeId x, NodeId y) {
+        if (isConst(x, false) || isConst(y, true) || x == y) {
+            return store.constant(true) ;
+        }
+        if (isConst(x, true)) {
+            return y ;
+        }
+        if (isConst(y, false)) {
+            return neg(x) ;
+        }
+        if (complementary(x, y)) { // x => !x is !x, !y => y is y
+            return y ;
+        }
+        return store.bin(BinOp::Imp, x, y) ;
+    }
+} ;
+
+NodeId simplify (FormulaStore& store, NodeId root)
+{
+    ProfileScope scope("simplify") ;
+    return Simplifier(store).run(root) ;
+}
+
+// atom ids of the formula, in increasing order
+vector<int> collectAtoms (const FormulaStore& store, NodeId root) 
+{
+    vector<bool> live = store.reachable(root) ;
+    vector<bool> used(store.symbols.size()) ;
+    for (NodeId id = 0; id <= root; id++) {
+        if (live[id] && store[id].kind == NodeKind::Atom) {
+            used[store[id].a] = true ;
+        }
+    }
+    vector<int> result ;
+    for (size_t atom = 0; atom < used.size(); atom++) {
+        if (used[atom]) {
+            result.push_back((int) atom) ;
+        }
+    }
+    return result ;
+}
+
+set<string> getAllAtomicProps (const FormulaStore& store, NodeId root) 
+{
+    ProfileScope scope("getAllAtomicProps") ;
+    set<string> result ;
+    for (int atom : collectAtoms(store, root)) {
+        result.insert(store.symbols.name(atom)) ;
+    }
+    return result ;   
+}
+
+// thrown by an engine whose stop flag was raised before it had an answer.
+// engines poll the flag at their natural checkpoints (between chunks,
+// conflicts, flips or BDD operations) and leave their state reusable
+class Cancelled : public runtime_error
+{
+public :
+    Cancelled () : runtime_error("Cancelled") {}
+} ;
+
+inline bool stopRequested (const atomic<bool>* stop)
+{
+    return stop && stop->load(memory_order_relaxed) ;
+}
+
+// runs body over the task range [0, numTasks) on a fixed number of threads.
+// each worker starts with an equal slice and takes one task at a time from
+// its front; a worker that runs dry steals the back half of the fullest
+// remaining slice. `stop` is checked between tasks so any worker can cancel
+// the others once the answer is known. the helper threads are started with
+// the pool and sleep between runs, so a query costs a wake-up rather than
+// a thread spawn per worker; the thread calling run() is worker 0
+class WorkStealingPool
+{
+public :
+    typedef function<void (uint64_t task, unsigned worker)> Body ;
+
+    explicit WorkStealingPool (unsigned workers)
+        : workers(workers == 0 ? 1 : workers), generation(0), busy(0), closing(false) {
+        for (unsigned i = 1; i < this->workers; i++) {
+            helpers.push_back(thread(&WorkStealingPool::help, this, i)) ;
+        }
+    }
+
+    ~WorkStealingPool ()
+    {
+        {
+            lock_guard<mutex> guard(lock) ;
+            closing = true ;
+        }
+        wake.notify_all() ;
+        for (thread& t : helpers) {
+            t.join() ;
+        }
+    }
+
+    WorkStealingPool (const WorkStealingPool&) = delete ;
+    WorkStealingPool& operator= (const WorkStealingPool&) = delete ;
+
+    // one pool per worker count, started on first use and kept until exit
+    static WorkStealingPool& shared (unsigned workers)
+    {
+        static mutex registryLock ;
+        static map<unsigned, unique_ptr<WorkStealingPool> > pools ;
+        lock_guard<mutex> guard(registryLock) ;
+        unique_ptr<WorkStealingPool>& pool = pools[workers == 0 ? 1 : workers] ;
+        if (!pool) {
+            pool.reset(new WorkStealingPool(workers)) ;
+        }
+        return *pool ;
+    }
+
+    unsigned size () const {
+        return workers ;
+    }
+
+    // one run at a time; concurrent callers wait their turn
+    void run (uint64_t numTasks, const Body& body, const atomic<bool>& stop)
+    {
+        unsigned n = (unsigned) min<uint64_t>(workers, numTasks) ;
+        if (n == 0) {
+            return ;
+        }
+        vector<Slice> slices(n) ;
+        for (unsigned i = 0; i < n; i++) {
+            slices[i].first = numTasks * i / n ;
+            slices[i].last = numTasks * (i + 1) / n ;
+        }
+        if (n == 1) {
+            work(0, slices, body, stop) ; // too little work to wake anyone
+            return ;
+        }
+        lock_guard<mutex> exclusive(runLock) ;
+
+        {
+            lock_guard<mutex> guard(lock) ;
+            Job next = { &slices, &body, &stop, n } ;
+            job = next ;
+            busy = n - 1 ;
+            generation++ ;
+        }
+        wake.notify_all() ;
+        work(0, slices, body, stop) ;
+        unique_lock<mutex> guard(lock) ;
+        idle.wait(guard, [this] { return busy == 0 ; }) ;
+    }
+
+private :
+    struct Slice ;
+
+    // what the current run() hands to the helpers
+    struct Job {
+        vector<Slice>* slices ;
+        const Body* body ;
+        const atomic<bool>* stop ;
+        unsigned numWorkers ;
+    } ;
+
+    unsigned workers ;
+    vector<thread> helpers ;
+    mutex runLock ;
+    mutex lock ;
+    condition_variable wake ;
+    condition_variable idle ;
+    Job job ;
+    uint64_t generation ; // bumped by every run()
+    unsigned busy ;       // helpers still working on the current run
+    bool closing ;
+
+    // helper id joins every run that has at least id + 1 workers
+    void help (unsigned id)
+    {
+        uint64_t seen = 0 ;
+        for (;;) {
+            Job current ;
+            {
+                unique_lock<mutex> guard(lock) ;
+                wake.wait(guard, [&] { return closing || generation != seen ; }) ;
+                if (closing) {
+                    return ;
+                }
+                seen = generation ;
+                current = job ;
+            }
+            if (id < current.numWorkers) {
+                work(id, *current.slices, *current.body, *current.stop) ;
+                lock_guard<mutex> guard(lock) ;
+                if (--busy == 0) {
+                    idle.notify_all() ;
+                }
+            }
+        }
+    }
+
+    struct Slice {
+        mutex lock ;
+        uint64_t first ;
+        uint64_t last ;
+    } ;
+
+    static void work (unsigned id, vector<Slice>& slices, const Body& body, const atomic<bool>& stop)
+    {
+        uint64_t task ;
+        while (!stop.load(memory_order_relaxed)) {
+            if (!take(slices[id], task) && !steal(id, slices, task)) {
+                return ;
+            }
+            body(task, id) ;
+        }
+    }
+
+    static bool take (Slice& slice, uint64_t& task)
+    {
+        lock_guard<mutex> guard(slice.lock) ;
+        if (slice.first == slice.last) {
+            return false ;
+        }
+        task = slice.first++ ;
+        return true ;
+    }
+
+    // moves the back half of the fullest other slice into our own slice
+    static bool steal (unsigned id, vector<Slice>& slices, uint64_t& task)
+    {
+        for (;;) {
+            unsigned victim = id ;
+            uint64_t most = 0 ;
+            for (unsigned i = 0; i < slices.size(); i++) {
+                lock_guard<mutex> guard(slices[i].lock) ;
+                if (i != id && slices[i].last - slices[i].first > most) {
+                    most = slices[i].last - slices[i].first ;
+                    victim = i ;
+                }
+            }
+            if (victim == id) {
+                return false ;
+            }
+
+            uint64_t first, last ;
+            {
+                lock_guard<mutex> guard(slices[victim].lock) ;
+                uint64_t remaining = slices[victim].last - slices[victim].first ;
+                if (remaining == 0) {
+                    continue ; // drained while we looked, pick another victim
+                }
+                last = slices[victim].last ;
+                first = last - (remaining + 1) / 2 ;
+                slices[victim].last = first ;
+            }
+
+            lock_guard<mutex> guard(slices[id].lock) ;
+            slices[id].first = first + 1 ;
+            slices[id].last = last ;
+            task = first ;
+            return true ;
+        }
+    }
+} ;
+
+// kernels over arrays of assignment words; the widest one the CPU supports
+// is picked at runtime, with the scalar loop as the portable fallback
+struct BitKernels
+{
+    const char* name ;
+    void (*andWords) (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n) ;
+    void (*orWords) (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n) ;
+    void (*impWords) (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n) ;
+    void (*notWords) (uint64_t* dst, const uint64_t* a, size_t n) ;
+
+    static const BitKernels& best () ;
+} ;
+
+void andWordsScalar (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] & b[i] ;
+}
+
+void orWordsScalar (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = a[i] | b[i] ;
+}
+
+void impWordsScalar (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = ~a[i] | b[i] ;
+}
+
+void notWordsScalar (uint64_t* dst, const uint64_t* a, size_t n)
+{
+    for (size_t i = 0; i < n; i++) dst[i] = ~a[i] ;
+}
+
+#if SAT_TT_X86_KERNELS
+
+// 256 assignments per instruction
+__attribute__((target("avx2")))
+void andWordsAvx2 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + i)) ;
+        __m256i y = _mm256_loadu_si256((const __m256i*) (b + i)) ;
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_and_si256(x, y)) ;
+    }
+    andWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx2")))
+void orWordsAvx2 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + i)) ;
+        __m256i y = _mm256_loadu_si256((const __m256i*) (b + i)) ;
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_or_si256(x, y)) ;
+    }
+    orWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx2")))
+void impWordsAvx2 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1) ;
+    size_t i = 0 ;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + i)) ;
+        __m256i y = _mm256_loadu_si256((const __m256i*) (b + i)) ;
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_or_si256(_mm256_xor_si256(x, ones), y)) ;
+    }
+    impWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx2")))
+void notWordsAvx2 (uint64_t* dst, const uint64_t* a, size_t n)
+{
+    const __m256i ones = _mm256_set1_epi64x(-1) ;
+    size_t i = 0 ;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*) (a + i)) ;
+        _mm256_storeu_si256((__m256i*) (dst + i), _mm256_xor_si256(x, ones)) ;
+    }
+    notWordsScalar(dst + i, a + i, n - i) ;
+}
+
+// 512 assignments per instruction; imp and not are single ternary-logic ops
+__attribute__((target("avx512f")))
+void andWordsAvx512 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i) ;
+        __m512i y = _mm512_loadu_si512(b + i) ;
+        _mm512_storeu_si512(dst + i, _mm512_and_si512(x, y)) ;
+    }
+    andWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx512f")))
+void orWordsAvx512 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i) ;
+        __m512i y = _mm512_loadu_si512(b + i) ;
+        _mm512_storeu_si512(dst + i, _mm512_or_si512(x, y)) ;
+    }
+    orWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx512f")))
+void impWordsAvx512 (uint64_t* dst, const uint64_t* a, const uint64_t* b, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i) ;
+        __m512i y = _mm512_loadu_si512(b + i) ;
+        _mm512_storeu_si512(dst + i, _mm512_ternarylogic_epi64(x, y, y, 0xCF)) ; // !x || y
+    }
+    impWordsScalar(dst + i, a + i, b + i, n - i) ;
+}
+
+__attribute__((target("avx512f")))
+void notWordsAvx512 (uint64_t* dst, const uint64_t* a, size_t n)
+{
+    size_t i = 0 ;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i) ;
+        _mm512_storeu_si512(dst + i, _mm512_ternarylogic_epi64(x, x, x, 0x55)) ; // !x
+    }
+    notWordsScalar(dst + i, a + i, n - i) ;
+}
+
+#endif
+
+const BitKernels& BitKernels::best ()
+{
+    static const BitKernels scalar = { "scalar", andWordsScalar, orWordsScalar, impWordsScalar, notWordsScalar } ;
+#if SAT_TT_X86_KERNELS
+    static const BitKernels avx2 = { "avx2", andWordsAvx2, orWordsAvx2, impWordsAvx2, notWordsAvx2 } ;
+    static const BitKernels avx512 = { "avx512", andWordsAvx512, orWordsAvx512, impWordsAvx512, notWordsAvx512 } ;
+
+    __builtin_cpu_init() ;
+    if (__builtin_cpu_supports("avx512f")) {
+        return avx512 ;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return avx2 ;
+    }
+#endif
+    return scalar ;
+}
+
+// arbitrary-precision unsigned integer for model counts, which can exceed
+// 64 bits once formulas have that many atoms
+class ModelCount
+{
+public :
+    ModelCount (uint64_t value = 0) {
+        while (value) {
+            limbs.push_back((uint32_t) value) ;
+            value >>= 32 ;
+        }
+    }
+
+    ModelCount& operator+= (const ModelCount& other) {
+        if (limbs.size() < other.limbs.size()) {
+            limbs.resize(other.limbs.size()) ;
+        }
+        uint64_t carry = 0 ;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            uint64_t sum = carry + limbs[i] + (i < other.limbs.size() ? other.limbs[i] : 0) ;
+            limbs[i] = (uint32_t) sum ;
+            carry = sum >> 32 ;
+        }
+        if (carry) {
+            limbs.push_back((uint32_t) carry) ;
+        }
+        return *this ;
+    }
+
+    // multiplies by 2^bits
+    ModelCount& operator<<= (unsigned bits) {
+        if (limbs.empty()) {
+            return *this ;
+        }
+        limbs.insert(limbs.begin(), bits / 32, 0) ;
+        unsigned shift = bits % 32 ;
+        if (shift) {
+            uint32_t carry = 0 ;
+            for (size_t i = 0; i < limbs.size(); i++) {
+                uint32_t next = limbs[i] >> (32 - shift) ;
+                limbs[i] = limbs[i] << shift | carry ;
+                carry = next ;
+            }
+            if (carry) {
+                limbs.push_back(carry) ;
+            }
+        }
+        return *this ;
+    }
+
+    bool operator== (const ModelCount& other) const {
+        return limbs == other.limbs ;
+    }
+
+    bool operator!= (const ModelCount& other) const {
+        return limbs != other.limbs ;
+    }
+
+    // requires other <= *this
+    ModelCount& operator-= (const ModelCount& other) {
+        int64_t borrow = 0 ;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            int64_t diff = (int64_t) limbs[i] - (i < other.limbs.size() ? other.limbs[i] : 0) - borrow ;
+            borrow = diff < 0 ;
+            limbs[i] = (uint32_t) (diff + (borrow << 32)) ;
+        }
+        while (!limbs.empty() && limbs.back() == 0) {
+            limbs.pop_back() ;
+        }
+        return *this ;
+    }
+
+    bool isZero () const {
+        return limbs.empty() ;
+    }
+
+    string to_string () const {
+        if (limbs.empty()) {
+            return "0" ;
+        }
+        vector<uint32_t> rest(limbs) ;
+        string digits ;
+        while (!rest.empty()) {
+            // divide by 10^9 and emit the remainder as nine digits
+            uint64_t remainder = 0 ;
+            for (size_t i = rest.size(); i-- > 0; ) {
+                uint64_t cur = remainder << 32 | rest[i] ;
+                rest[i] = (uint32_t) (cur / 1000000000) ;
+                remainder = cur % 1000000000 ;
+            }
+            while (!rest.empty() && rest.back() == 0) {
+                rest.pop_back() ;
+            }
+            for (int k = 0; k < 9; k++) {
+                digits += (char) ('0' + remainder % 10) ;
+                remainder /= 10 ;
+            }
+        }
+        while (digits.size() > 1 && digits.back() == '0') {
+            digits.pop_back() ;
+        }
+        return string(digits.rbegin(), digits.rend()) ;
+    }
+
+private :
+    vector<uint32_t> limbs ; // little-endian base 2^32, no leading zero limbs
+} ;
+
+// truth table over n atoms cut into blocks of 64 assignments, shared by
+// the bit-sliced and JIT backends: assignment x of block b is bit (x % 64)
+// of each word, and atom k takes bit k of (64 * b + x)
+class TruthTableLayout
+{
+public :
+    static const size_t kMaxAtoms = 62 ;
+
+    explicit TruthTableLayout (size_t numAtoms = 0) : numAtoms(numAtoms) {
+        if (numAtoms > kMaxAtoms) {
+            throw runtime_error("Too many atoms for truth-table enumeration") ;
+        }
+    }
+
+    uint64_t numBlocks () const {
+        return numAtoms <= 6 ? 1 : (uint64_t) 1 << (numAtoms - 6) ;
+    }
+
+    // with fewer than 6 atoms only the low 2^n bits of the single block are real assignments
+    uint64_t validMask () const {
+        return numAtoms >= 6 ? ~(uint64_t) 0 : ((uint64_t) 1 << (1u << numAtoms)) - 1 ;
+    }
+
+    // values of atom k across block b; the low six atoms are the same in every block
+    static uint64_t atomWord (size_t k, uint64_t block) {
+        static const uint64_t lowPatterns[6] = {
+            0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+            0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+        } ;
+        if (k < 6) {
+            return lowPatterns[k] ;
+        }
+        return ((block >> (k - 6)) & 1) ? ~(uint64_t) 0 : 0 ;
+    }
+
+private :
+    size_t numAtoms ;
+} ;
+
+// truth table built with the TruthTableLayout, 64 assignments at a time.
+// blocks are evaluated kChunkWords at a time so each operator runs as one
+// kernel call over the whole chunk
+class BitSlicedEvaluator
+{
+public :
+    static const size_t kChunkWords = 16 ;
+
+    // one instruction per distinct node reachable from root, so a subformula
+    // shared in the DAG is computed once per chunk; the atoms become
+    // truth-table variables in order of first appearance
+    BitSlicedEvaluator (const FormulaStore& store, NodeId root)
+        : numAtoms(0), kernels(BitKernels::best()), stop(nullptr) {
+        compile(store, root) ;
+        layout = TruthTableLayout(numAtoms) ;
+    }
+
+    // satisfiable iff some bit of the truth table is set
+    bool anySet () const
+    {
+        return findChunk(true, 1) ;
+    }
+
+    // valid iff every bit of the truth table is set
+    bool allSet () const
+    {
+        return !findChunk(false, 1) ;
+    }
+
+    // same checks with the chunks spread over a work-stealing pool; the
+    // first worker to find a deciding chunk stops the others
+    bool anySetParallel (unsigned threads) const
+    {
+        return findChunk(true, threads) ;
+    }
+
+    bool allSetParallel (unsigned threads) const
+    {
+        return !findChunk(false, threads) ;
+    }
+
+    // number of set bits in the truth table: a popcount per word, summed
+    // per worker and added up at the end
+    ModelCount countSet (unsigned threads) const
+    {
+        return scan(threads, nullptr).count ;
+    }
+
+    // what one full pass over the truth table tells: the model count and
+    // the first satisfying and first falsifying assignment, -1 if there is
+    // none. assignment i gives truth-table variable k the value of bit k of i
+    struct TableScan {
+        ModelCount count ;
+        int64_t firstSet ;
+        int64_t firstClear ;
+    } ;
+
+    // visits every chunk; if table is given it receives the whole truth
+    // table, bit i % 64 of word i / 64 being the value under assignment i
+    TableScan scan (unsigned threads, vector<uint64_t>* table) const
+    {
+        size_t n = chunkWords() ;
+        uint64_t mask = validMask() ;
+        atomic<bool> cancelled(false) ;
+        WorkStealingPool& pool = WorkStealingPool::shared(threads) ;
+        unsigned workers = (unsigned) min<uint64_t>(pool.size(), numChunks()) ;
+        vector<vector<uint64_t> > slots(workers) ;
+        vector<uint64_t> partial(8 * workers) ; // one cache line apart
+        vector<int64_t> firsts(8 * workers, -1) ; // first set, first clear
+        if (table) {
+            table->assign(numBlocks(), 0) ;
+        }
+
+        pool.run(numChunks(), [&] (uint64_t chunk, unsigned worker) {
+            if (stopRequested(stop)) {
+                cancelled = true ;
+                return ;
+            }
+            if (slots[worker].empty()) {
+                slots[worker].resize(program.size() * n) ;
+            }
+            const uint64_t* result = evalChunk(chunk, slots[worker]) ;
+            reportChunk() ;
+            uint64_t count = 0 ;
+            for (size_t w = 0; w < n; w++) {
+                uint64_t bits = result[w] & mask ;
+                count += __builtin_popcountll(bits) ;
+                int64_t base = (int64_t) ((chunk * n + w) * 64) ;
+                noteFirst(firsts[8 * worker], bits, base) ;
+                noteFirst(firsts[8 * worker + 1], ~result[w] & mask, base) ;
+                if (table) {
+                    (*table)[chunk * n + w] = bits ;
+                }
+            }
+            partial[8 * worker] += count ;
+        }, cancelled) ;
+
+        if (cancelled) {
+            throw Cancelled() ;
+        }
+        TableScan result = { ModelCount(), -1, -1 } ;
+        for (unsigned i = 0; i < workers; i++) {
+            result.count += ModelCount(partial[8 * i]) ;
+            noteFirst(result.firstSet, firsts[8 * i]) ;
+            noteFirst(result.firstClear, firsts[8 * i + 1]) ;
+        }
+        return result ;
+    }
+
+    // symbol id of truth-table variable k
+    int atomId (size_t k) const {
+        return atomIds[k] ;
+    }
+
+    // checked between chunks; a raised flag makes the query throw Cancelled
+    void setStop (const atomic<bool>* flag) {
+        stop = flag ;
+    }
+
+    size_t atomCount () const {
+        return numAtoms ;
+    }
+
+    const char* kernelName () const {
+        return kernels.name ;
+    }
+
+private :
+    enum class OpCode { Atom, Const, Not, And, Or, Imp } ;
+
+    // the result of instruction i goes to slot i
+    struct Instr {
+        OpCode op ;
+        int a ;
+        int b ;
+    } ;
+
+    vector<Instr> program ;
+    size_t numAtoms ;
+    TruthTableLayout layout ;
+    vector<int> atomIds ;
+    const BitKernels& kernels ;
+    const atomic<bool>* stop ;
+
+    // keeps the smaller of two assignment indexes, -1 meaning none
+    static void noteFirst (int64_t& first, int64_t index) {
+        if (index >= 0 && (first < 0 || index < first)) {
+            first = index ;
+        }
+    }
+
+    static void noteFirst (int64_t& first, uint64_t bits, int64_t base) {
+        if (bits) {
+            noteFirst(first, base + __builtin_ctzll(bits)) ;
+        }
+    }
+
+    int emit (OpCode op, int a, int b) {
+        Instr instr = { op, a, b } ;
+        program.push_back(instr) ;
+        return (int) program.size() - 1 ;
+    }
+
+    // store ids are topologically ordered, so walking them upwards emits
+    // every operand before its users and ends with the root
+    void compile (const FormulaStore& store, NodeId root) {
+        vector<bool> live = store.reachable(root) ;
+        vector<int> slot(root + 1, -1) ;
+        vector<int> atomIndex(store.symbols.size(), -1) ;
+        for (NodeId id = 0; id <= root; id++) {
+            if (!live[id]) {
+                continue ;
+            }
+            const Node& n = store[id] ;
+            switch (n.kind) {
+                case NodeKind::Atom:
+                    if (atomIndex[n.a] < 0) {
+                        atomIndex[n.a] = (int) numAtoms++ ;
+                        atomIds.push_back(n.a) ;
+                    }
+                    slot[id] = emit(OpCode::Atom, atomIndex[n.a], 0) ;
+                    break ;
+                case NodeKind::Const: slot[id] = emit(OpCode::Const, n.a, 0) ; break ;
+                case NodeKind::Neg: slot[id] = emit(OpCode::Not, slot[n.a], 0) ; break ;
+                case NodeKind::And: slot[id] = emit(OpCode::And, slot[n.a], slot[n.b]) ; break ;
+                case NodeKind::Or: slot[id] = emit(OpCode::Or, slot[n.a], slot[n.b]) ; break ;
+                case NodeKind::Imp: slot[id] = emit(OpCode::Imp, slot[n.a], slot[n.b]) ; break ;
+            }
+        }
+    }
+
+    uint64_t numBlocks () const {
+        return layout.numBlocks() ;
+    }
+
+    // small formulas fit in less than one chunk
+    size_t chunkWords () const {
+        return numBlocks() < kChunkWords ? (size_t) numBlocks() : kChunkWords ;
+    }
+
+    uint64_t numChunks () const {
+        return numBlocks() / chunkWords() ;
+    }
+
+    uint64_t validMask () const {
+        return layout.validMask() ;
+    }
+
+    uint64_t atomWord (int k, uint64_t block) const {
+        return TruthTableLayout::atomWord(k, block) ;
+    }
+
+    // one word per node and block of 64 assignments
+    void reportChunk () const {
+        uint64_t words = chunkWords() ;
+        Profiler::global().count(Profiler::Assignments, min<uint64_t>(64 * words, (uint64_t) 1 << numAtoms)) ;
+        Profiler::global().count(Profiler::NodeVisits, program.size() * words) ;
+    }
+
+    // looks for a chunk holding a set bit (lookForSet) or a clear bit (!lookForSet)
+    bool findChunk (bool lookForSet, unsigned threads) const
+    {
+        size_t n = chunkWords() ;
+        uint64_t mask = validMask() ;
+        atomic<bool> found(false) ;
+        atomic<bool> cancelled(false) ;
+        WorkStealingPool& pool = WorkStealingPool::shared(threads) ;
+        vector<vector<uint64_t> > slots(min<uint64_t>(pool.size(), numChunks())) ;
+
+        pool.run(numChunks(), [&] (uint64_t chunk, unsigned worker) {
+            if (stopRequested(stop)) {
+                cancelled = true ;
+                found = true ; // halts the pool
+                return ;
+            }
+            if (slots[worker].empty()) {
+                slots[worker].resize(program.size() * n) ;
+            }
+            const uint64_t* result = evalChunk(chunk, slots[worker]) ;
+            reportChunk() ;
+            for (size_t w = 0; w < n; w++) {
+                uint64_t bits = lookForSet ? result[w] : ~result[w] ;
+                if (bits & mask) {
+                    found = true ;
+                    return ;
+                }
+            }
+        }, found) ;
+
+        if (cancelled) {
+            throw Cancelled() ;
+        }
+        return found ;
+    }
+
+    // returns the root's words for the chunk
+    const uint64_t* evalChunk (uint64_t chunk, vector<uint64_t>& slots) const {
+        size_t n = chunkWords() ;
+        uint64_t firstBlock = chunk * n ;
+        for (size_t i = 0; i < program.size(); i++) {
+            const Instr& instr = program[i] ;
+            uint64_t* dst = &slots[i * n] ;
+            const uint64_t* a = &slots[instr.a * n] ;
+            const uint64_t* b = &slots[instr.b * n] ;
+            switch (instr.op) {
+                case OpCode::Atom:
+                    for (size_t w = 0; w < n; w++) dst[w] = atomWord(instr.a, firstBlock + w) ;
+                    break ;
+                case OpCode::Const:
+                    for (size_t w = 0; w < n; w++) dst[w] = instr.a ? ~(uint64_t) 0 : 0 ;
+                    break ;
+                case OpCode::Not: kernels.notWords(dst, a, n) ; break ;
+                case OpCode::And: kernels.andWords(dst, a, b, n) ; break ;
+                case OpCode::Or: kernels.orWords(dst, a, b, n) ; break ;
+                case OpCode::Imp: kernels.impWords(dst, a, b, n) ; break ;
+            }
+        }
+        return &slots[(program.size() - 1) * n] ;
+    }
+} ;
+
+// compiles a formula into straight-line x86-64 code that evaluates one
+// 64-bit block of the truth table, so the enumeration loop calls native
+// code instead of dispatching on node kinds. the generated function is
+//     uint64_t block (const uint64_t* atomWords, uint64_t* scratch)
+// where atomWords[k] holds the values of variable k across the block and
+// every non-atom node has a scratch word. rax carries the last result, so
+// a node whose operand was just computed skips the reload. the code is
+// written into an mmap'd buffer which is then made read-execute only
+class JitEvaluator
+{
+public :
+    JitEvaluator (const FormulaStore& store, NodeId root)
+        : numAtoms(0), numScratch(0), code(nullptr), codeSize(0), stop(nullptr) {
+        ProfileScope scope("jitCompile") ;
+        if (!supported()) {
+            throw runtime_error("The JIT backend needs x86-64 Linux") ;
+        }
+        compile(store, root) ;
+        layout = TruthTableLayout(numAtoms) ;
+        install() ;
+    }
+
+    ~JitEvaluator ()
+    {
+        if (code) {
+            munmap(code, codeSize) ;
+        }
+    }
+
+    JitEvaluator (const JitEvaluator&) = delete ;
+    JitEvaluator& operator= (const JitEvaluator&) = delete ;
+
+    static bool supported ()
+    {
+        return SAT_TT_JIT ;
+    }
+
+    // checked between tasks of kBlocksPerTask blocks
+    void setStop (const atomic<bool>* flag)
+    {
+        stop = flag ;
+    }
+
+    bool anySet (unsigned threads) const
+    {
+        return findBlock(true, threads) ;
+    }
+
+    bool allSet (unsigned threads) const
+    {
+        return !findBlock(false, threads) ;
+    }
+
+    ModelCount countSet (unsigned threads) const
+    {
+        atomic<bool> cancelled(false) ;
+        WorkStealingPool& pool = WorkStealingPool::shared(threads) ;
+        vector<uint64_t> partial(8 * pool.size()) ; // one cache line apart
+        vector<Buffers> buffers(pool.size()) ;
+
+        pool.run(numTasks(), [&] (uint64_t task, unsigned worker) {
+            if (stopRequested(stop)) {
+                cancelled = true ;
+                return ;
+            }
+            uint64_t count = 0 ;
+            forBlocks(task, buffers[worker], [&] (uint64_t bits) {
+                count += __builtin_popcountll(bits) ;
+                return false ;
+            }) ;
+            partial[8 * worker] += count ;
+        }, cancelled) ;
+
+        if (cancelled) {
+            throw Cancelled() ;
+        }
+        ModelCount total ;
+        for (unsigned i = 0; i < pool.size(); i++) {
+            total += ModelCount(partial[8 * i]) ;
+        }
+        return total ;
+    }
+
+private :
+    static const uint64_t kBlocksPerTask = 1024 ;
+
+    typedef uint64_t (*BlockFn) (const uint64_t* atomWords, uint64_t* scratch) ;
+
+    // where a node's word lives: atomWords (rdi) or scratch (rsi)
+    struct Location {
+        bool atom ;
+        int32_t index ;
+    } ;
+
+    struct Buffers {
+        vector<uint64_t> atomWords ;
+        vector<uint64_t> scratch ;
+    } ;
+
+    size_t numAtoms ;
+    TruthTableLayout layout ;
+    size_t numScratch ;
+    vector<uint8_t> bytes ;
+    void* code ;
+    size_t codeSize ;
+    const atomic<bool>* stop ;
+
+    void emit (std::initializer_list<uint8_t> op) {
+        bytes.insert(bytes.end(), op) ;
+    }
+
+    void emit32 (int32_t value) {
+        for (int i = 0; i < 4; i++) {
+            bytes.push_back((uint8_t) (value >> (8 * i))) ;
+        }
+    }
+
+    // opcode rax, [rdi + disp32] or [rsi + disp32], with REX.W
+    void emitMemory (uint8_t opcode, Location loc) {
+        emit({ 0x48, opcode, (uint8_t) (loc.atom ? 0x87 : 0x86) }) ;
+        emit32(8 * loc.index) ;
+    }
+
+    void compile (const FormulaStore& store, NodeId root) {
+        vector<bool> live = store.reachable(root) ;
+        vector<Location> where(root + 1) ;
+        vector<int> atomIndex(store.symbols.size(), -1) ;
+        NodeId inRax = -1 ;
+
+        for (NodeId id = 0; id <= root; id++) {
+            if (!live[id]) {
+                continue ;
+            }
+            Node n = store[id] ;
+            if (n.kind == NodeKind::Atom) {
+                if (atomIndex[n.a] < 0) {
+                    atomIndex[n.a] = (int) numAtoms++ ;
+                }
+                Location loc = { true, atomIndex[n.a] } ;
+                where[id] = loc ;
+                continue ;
+            }
+            if ((n.kind == NodeKind::And || n.kind == NodeKind::Or) && n.b == inRax) {
+                swap(n.a, n.b) ;
+            }
+            switch (n.kind) {
+                case NodeKind::Const:
+                    if (n.a) {
+                        emit({ 0x48, 0xC7, 0xC0, 0xFF, 0xFF, 0xFF, 0xFF }) ; // mov rax, -1
+                    } else {
+                        emit({ 0x48, 0x31, 0xC0 }) ;                         // xor rax, rax
+                    }
+                    break ;
+                case NodeKind::Neg:
+                    load(where[n.a], n.a, inRax) ;
+                    emit({ 0x48, 0xF7, 0xD0 }) ;                             // not rax
+                    break ;
+                case NodeKind::And:
+                    load(where[n.a], n.a, inRax) ;
+                    emitMemory(0x23, where[n.b]) ;                           // and rax, [b]
+                    break ;
+                case NodeKind::Or:
+                    load(where[n.a], n.a, inRax) ;
+                    emitMemory(0x0B, where[n.b]) ;                           // or rax, [b]
+                    break ;
+                case NodeKind::Imp:
+                    load(where[n.a], n.a, inRax) ;
+                    emit({ 0x48, 0xF7, 0xD0 }) ;
+                    emitMemory(0x0B, where[n.b]) ;
+                    break ;
+                default:
+                    break ;
+            }
+            Location loc = { false, (int32_t) numScratch++ } ;
+            where[id] = loc ;
+            emitMemory(0x89, loc) ;                                          // mov [slot], rax
+            inRax = id ;
+        }
+        load(where[root], root, inRax) ;
+        emit({ 0xC3 }) ;                                                     // ret
+    }
+
+    void load (Location loc, NodeId id, NodeId inRax) {
+        if (id != inRax) {
+            emitMemory(0x8B, loc) ;                                          // mov rax, [loc]
+        }
+    }
+
+    // pages are never writable and executable at once
+    void install () {
+        codeSize = bytes.size() ;
+        code = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) ;
+        if (code == MAP_FAILED) {
+            code = nullptr ;
+            throw runtime_error("Cannot map memory for the JIT") ;
+        }
+        memcpy(code, bytes.data(), codeSize) ;
+        if (mprotect(code, codeSize, PROT_READ | PROT_EXEC) != 0) {
+            // the constructor is failing, so the destructor will not unmap it
+            munmap(code, codeSize) ;
+            code = nullptr ;
+            throw runtime_error("Cannot make the JIT code executable") ;
+        }
+        vector<uint8_t>().swap(bytes) ;
+    }
+
+    uint64_t numBlocks () const {
+        return layout.numBlocks() ;
+    }
+
+    uint64_t numTasks () const {
+        return (numBlocks() + kBlocksPerTask - 1) / kBlocksPerTask ;
+    }
+
+    uint64_t validMask () const {
+        return layout.validMask() ;
+    }
+
+    // calls visit with the root's word for every block of the task, until
+    // visit returns true; returns whether it did
+    template <typename Visit>
+    bool forBlocks (uint64_t task, Buffers& buffers, Visit visit) const {
+        if (buffers.atomWords.empty()) {
+            buffers.atomWords.resize(max<size_t>(numAtoms, 1)) ;
+            buffers.scratch.resize(max<size_t>(numScratch, 1)) ;
+            for (size_t k = 0; k < numAtoms && k < 6; k++) {
+                buffers.atomWords[k] = TruthTableLayout::atomWord(k, 0) ;
+            }
+        }
+        BlockFn block = (BlockFn) code ;
+        uint64_t mask = validMask() ;
+        uint64_t first = task * kBlocksPerTask ;
+        uint64_t last = min(first + kBlocksPerTask, numBlocks()) ;
+        uint64_t b = first ;
+        bool stopped = false ;
+        for (; !stopped && b < last; b++) {
+            for (size_t k = 6; k < numAtoms; k++) {
+                buffers.atomWords[k] = TruthTableLayout::atomWord(k, b) ;
+            }
+            stopped = visit(block(buffers.atomWords.data(), buffers.scratch.data()) & mask) ;
+        }
+        Profiler::global().count(Profiler::Assignments, min<uint64_t>(64 * (b - first), (uint64_t) 1 << numAtoms)) ;
+        Profiler::global().count(Profiler::NodeVisits, numScratch * (b - first)) ;
+        return stopped ;
+    }
+
+    bool findBlock (bool lookForSet, unsigned threads) const
+    {
+        atomic<bool> found(false) ;
+        atomic<bool> cancelled(false) ;
+        WorkStealingPool& pool = WorkStealingPool::shared(threads) ;
+        vector<Buffers> buffers(pool.size()) ;
+        uint64_t mask = validMask() ;
+
+        pool.run(numTasks(), [&] (uint64_t task, unsigned worker) {
+            if (stopRequested(stop)) {
+                cancelled = true ;
+                found = true ; // halts the pool
+                return ;
+            }
+            bool hit = forBlocks(task, buffers[worker], [&] (uint64_t bits) {
+                return ((lookForSet ? bits : ~bits) & mask) != 0 ;
+            }) ;
+            if (hit) {
+                found = true ;
+            }
+        }, found) ;
+
+        if (cancelled) {
+            throw Cancelled() ;
+        }
+        return found ;
+    }
+} ;
+
+// conflict-driven clause learning over DIMACS-style literals (+v / -v, v >= 1).
+// two watched literals with blockers, VSIDS branching with phase saving,
+// first-UIP learning with clause minimization, Luby restarts and periodic
+// deletion of learnt clauses with high literal block distance
+class CdclSolver
+{
+public :
+    CdclSolver () : ok(true), qhead(0), varInc(1), clauseInc(1), numLearnts(0), maxLearnts(0), conflicts(0),
+                    stop(nullptr) {}
+
+    // checked before every decision; a raised flag makes solve() throw
+    // Cancelled with the solver back at level 0 and still usable
+    void setStop (const atomic<bool>* flag)
+    {
+        stop = flag ;
+    }
+
+    int newVar ()
+    {
+        int v = (int) assigns.size() ;
+        assigns.push_back(Undef) ;
+        level.push_back(0) ;
+        reason.push_back(-1) ;
+        activity.push_back(0) ;
+        polarity.push_back(1) ;
+        seen.push_back(0) ;
+        heapIndex.push_back(-1) ;
+        watches.resize(2 * assigns.size()) ;
+        heapInsert(v) ;
+        return v + 1 ;
+    }
+
+    int numVars () const
+    {
+        return (int) assigns.size() ;
+    }
+
+    // clauses may be added before and between solve() calls; learnt clauses
+    // follow from the clause set alone, so they stay valid as it grows.
+    // false once the clause set is unsatisfiable
+    bool addClause (const vector<int>& dimacs)
+    {
+        if (!ok) {
+            return false ;
+        }
+        vector<int> lits ;
+        for (int d : dimacs) {
+            if (d == 0 || abs(d) > numVars()) {
+                throw runtime_error("Clause literal out of range: " + std::to_string(d)) ;
+            }
+            lits.push_back(toLit(d)) ;
+        }
+        sort(lits.begin(), lits.end()) ;
+
+        // drop duplicates and literals false at the root, skip tautologies and satisfied clauses
+        size_t j = 0 ;
+        for (size_t i = 0; i < lits.size(); i++) {
+            if (value(lits[i]) == True || (j > 0 && lits[i] == (lits[j - 1] ^ 1))) {
+                return true ;
+            }
+            if (value(lits[i]) != False && (j == 0 || lits[i] != lits[j - 1])) {
+                lits[j++] = lits[i] ;
+            }
+        }
+        lits.resize(j) ;
+
+        if (lits.empty()) {
+            ok = false ;
+        } else if (lits.size() == 1) {
+            enqueue(lits[0], -1) ;
+            ok = propagate() == -1 ;
+        } else {
+            attach(newClause(lits, false)) ;
+        }
+        return ok ;
+    }
+
+    // assumptions are DIMACS literals that hold for this call only. they are
+    // decided first, one per decision level, so an unsatisfiable answer
+    // that depends on them leaves the clause set usable and the assumptions
+    // at fault in failedAssumptions()
+    bool solve (const vector<int>& assumed = vector<int>())
+    {
+        ProfileScope scope("cdcl") ;
+        model.clear() ;
+        conflictSet.clear() ;
+        if (!ok) {
+            return false ;
+        }
+        assumptions.clear() ;
+        for (int d : assumed) {
+            if (d == 0 || abs(d) > numVars()) {
+                throw runtime_error("Assumption literal out of range: " + std::to_string(d)) ;
+            }
+            assumptions.push_back(toLit(d)) ;
+        }
+        maxLearnts = max<size_t>(clauses.size() / 3, 2000) ;
+
+        long conflictsBefore = conflicts ;
+        Value status = Undef ;
+        for (int restart = 0; status == Undef; restart++) {
+            status = search((long) (luby(restart) * 100)) ;
+            if (status == Undef && stopRequested(stop)) {
+                throw Cancelled() ;
+            }
+        }
+        Profiler::global().count(Profiler::Conflicts, conflicts - conflictsBefore) ;
+        if (status == True) {
+            model.resize(assigns.size()) ;
+            for (size_t v = 0; v < assigns.size(); v++) {
+                model[v] = assigns[v] == True ;
+            }
+        } else if (conflictSet.empty()) {
+            ok = false ;
+        }
+        cancelUntil(0) ;
+        return status == True ;
+    }
+
+    // after an unsatisfiable solve() under assumptions: a subset of them
+    // that cannot hold together, empty if the clauses alone are unsatisfiable
+    const vector<int>& failedAssumptions () const
+    {
+        return conflictSet ;
+    }
+
+    // value of a variable in the model found by the last successful solve()
+    bool modelValue (int var) const
+    {
+        return model[var - 1] ;
+    }
+
+    // variables the model covers: none after an unsatisfiable solve(), and
+    // variables created since the last solve() are not in it
+    int modelVars () const
+    {
+        return (int) model.size() ;
+    }
+
+    long numConflicts () const
+    {
+        return conflicts ;
+    }
+
+private :
+    enum Value : signed char { False = 0, True = 1, Undef = 2 } ;
+
+    struct Clause {
+        vector<int> lits ;
+        bool learnt ;
+        bool deleted ;
+        int lbd ;
+        double activity ;
+    } ;
+
+    struct Watcher {
+        int clause ;
+        int blocker ;
+    } ;
+
+    bool ok ;
+    vector<Clause> clauses ;
+    vector<vector<Watcher> > watches ; // watches[p]: clauses watching ~p
+    vector<Value> assigns ;
+    vector<int> level ;
+    vector<int> reason ;
+    vector<int> trail ;
+    vector<int> trailLim ;
+    size_t qhead ;
+    vector<double> activity ;
+    double varInc ;
+    double clauseInc ;
+    vector<char> polarity ;
+    vector<char> seen ;
+    vector<int> heap ;
+    vector<int> heapIndex ;
+    size_t numLearnts ;
+    size_t maxLearnts ;
+    long conflicts ;
+    vector<bool> model ;
+    vector<int> assumptions ; // internal literals, one per leading decision level
+    vector<int> conflictSet ; // DIMACS literals
+    const atomic<bool>* stop ;
+
+    // internal literals are 2 * var + sign with 0-based vars
+    static int toLit (int dimacs) {
+        return dimacs > 0 ? 2 * (dimacs - 1) : 2 * (-dimacs - 1) + 1 ;
+    }
+
+    static int var (int lit) {
+        return lit >> 1 ;
+    }
+
+    static int toDimacs (int lit) {
+        return (lit & 1) ? -(var(lit) + 1) : var(lit) + 1 ;
+    }
+
+    Value value (int lit) const {
+        Value v = assigns[var(lit)] ;
+        return v == Undef ? Undef : (Value) (v ^ (lit & 1)) ;
+    }
+
+    int decisionLevel () const {
+        return (int) trailLim.size() ;
+    }
+
+    void enqueue (int lit, int from) {
+        assigns[var(lit)] = (Value) !(lit & 1) ;
+        level[var(lit)] = decisionLevel() ;
+        reason[var(lit)] = from ;
+        trail.push_back(lit) ;
+    }
+
+    int newClause (const vector<int>& lits, bool learnt) {
+        Clause c = { lits, learnt, false, 0, 0 } ;
+        clauses.push_back(c) ;
+        return (int) clauses.size() - 1 ;
+    }
+
+    void attach (int cref) {
+        const Clause& c = clauses[cref] ;
+        Watcher w0 = { cref, c.lits[1] } ;
+        Watcher w1 = { cref, c.lits[0] } ;
+        watches[c.lits[0] ^ 1].push_back(w0) ;
+        watches[c.lits[1] ^ 1].push_back(w1) ;
+    }
+
+    // returns the conflicting clause, or -1
+    int propagate ()
+    {
+        int conflict = -1 ;
+        while (qhead < trail.size()) {
+            int p = trail[qhead++] ;
+            int falseLit = p ^ 1 ;
+            vector<Watcher>& ws = watches[p] ;
+            size_t i = 0, j = 0 ;
+            while (i < ws.size()) {
+                Watcher w = ws[i++] ;
+                if (value(w.blocker) == True) {
+                    ws[j++] = w ;
+                    continue ;
+                }
+                Clause& c = clauses[w.clause] ;
+                if (c.deleted) {
+                    continue ;
+                }
+                if (c.lits[0] == falseLit) {
+                    swap(c.lits[0], c.lits[1]) ;
+                }
+                int first = c.lits[0] ;
+                Watcher kept = { w.clause, first } ;
+                if (first != w.blocker && value(first) == True) {
+                    ws[j++] = kept ;
+                    continue ;
+                }
+
+                bool moved = false ;
+                for (size_t k = 2; k < c.lits.size(); k++) {
+                    if (value(c.lits[k]) != False) {
+                        c.lits[1] = c.lits[k] ;
+                        c.lits[k] = falseLit ;
+                        watches[c.lits[1] ^ 1].push_back(kept) ;
+                        moved = true ;
+                        break ;
+                    }
+                }
+                if (moved) {
+                    continue ;
+                }
+
+                ws[j++] = kept ;
+                if (value(first) == False) {
+                    conflict = w.clause ;
+                    qhead = trail.size() ;
+                    while (i < ws.size()) {
+                        ws[j++] = ws[i++] ;
+                    }
+                } else {
+                    enqueue(first, w.clause) ;
+                }
+            }
+            ws.resize(j) ;
+        }
+        return conflict ;
+    }
+
+    // first-UIP learning; learnt[0] is the asserting literal and learnt[1]
+    // (if any) the literal with the highest level below the conflict level
+    void analyze (int conflict, vector<int>& learnt, int& backtrackLevel)
+    {
+        learnt.assign(1, -1) ;
+        int pathCount = 0 ;
+        int p = -1 ;
+        size_t index = trail.size() ;
+
+        do {
+            Clause& c = clauses[conflict] ;
+            if (c.learnt) {
+                bumpClause(c) ;
+            }
+            for (size_t j = (p == -1 ? 0 : 1); j < c.lits.size(); j++) {
+                int q = c.lits[j] ;
+                int v = var(q) ;
+                if (!seen[v] && level[v] > 0) {
+                    bumpVar(v) ;
+                    seen[v] = 1 ;
+                    if (level[v] >= decisionLevel()) {
+                        pathCount++ ;
+                    } else {
+                        learnt.push_back(q) ;
+                    }
+                }
+            }
+            while (!seen[var(trail[--index])]) ;
+            p = trail[index] ;
+            conflict = reason[var(p)] ;
+            seen[var(p)] = 0 ;
+            pathCount-- ;
+        } while (pathCount > 0) ;
+        learnt[0] = p ^ 1 ;
+
+        // drop literals implied by the rest of the clause
+        vector<int> marked(learnt.begin() + 1, learnt.end()) ;
+        size_t j = 1 ;
+        for (size_t i = 1; i < learnt.size(); i++) {
+            int from = reason[var(learnt[i])] ;
+            bool redundant = from != -1 ;
+            if (redundant) {
+                const vector<int>& lits = clauses[from].lits ;
+                for (size_t k = 1; k < lits.size() && redundant; k++) {
+                    redundant = seen[var(lits[k])] || level[var(lits[k])] == 0 ;
+                }
+            }
+            if (!redundant) {
+                learnt[j++] = learnt[i] ;
+            }
+        }
+        learnt.resize(j) ;
+        for (int q : marked) {
+            seen[var(q)] = 0 ;
+        }
+
+        backtrackLevel = 0 ;
+        if (learnt.size() > 1) {
+            size_t maxIndex = 1 ;
+            for (size_t i = 2; i < learnt.size(); i++) {
+                if (level[var(learnt[i])] > level[var(learnt[maxIndex])]) {
+                    maxIndex = i ;
+                }
+            }
+            swap(learnt[1], learnt[maxIndex]) ;
+            backtrackLevel = level[var(learnt[1])] ;
+        }
+    }
+
+    // fills conflictSet with the assumption `failed`, found false, and the
+    // assumptions that imply its negation. while assumptions are being
+    // decided every decision on the trail is one of them
+    void analyzeFinal (int failed)
+    {
+        conflictSet.assign(1, toDimacs(failed)) ;
+        if (decisionLevel() == 0) {
+            return ;
+        }
+        seen[var(failed)] = 1 ;
+        for (size_t i = trail.size(); i > (size_t) trailLim[0]; i--) {
+            int v = var(trail[i - 1]) ;
+            if (!seen[v]) {
+                continue ;
+            }
+            if (reason[v] == -1) {
+                conflictSet.push_back(toDimacs(trail[i - 1])) ;
+            } else {
+                const vector<int>& lits = clauses[reason[v]].lits ;
+                for (size_t k = 1; k < lits.size(); k++) {
+                    if (level[var(lits[k])] > 0) {
+                        seen[var(lits[k])] = 1 ;
+                    }
+                }
+            }
+            seen[v] = 0 ;
+        }
+        seen[var(failed)] = 0 ;
+    }
+
+    int blockDistance (const vector<int>& lits)
+    {
+        set<int> levels ;
+        for (int lit : lits) {
+            levels.insert(level[var(lit)]) ;
+        }
+        return (int) levels.size() ;
+    }
+
+    void cancelUntil (int target)
+    {
+        if (decisionLevel() <= target) {
+            return ;
+        }
+        for (size_t i = trail.size(); i > (size_t) trailLim[target]; i--) {
+            int v = var(trail[i - 1]) ;
+            assigns[v] = Undef ;
+            reason[v] = -1 ;
+            polarity[v] = trail[i - 1] & 1 ;
+            if (heapIndex[v] < 0) {
+                heapInsert(v) ;
+            }
+        }
+        trail.resize(trailLim[target]) ;
+        trailLim.resize(target) ;
+        qhead = trail.size() ;
+    }
+
+    Value search (long conflictBudget)
+    {
+        long conflictsHere = 0 ;
+        vector<int> learnt ;
+        for (;;) {
+            int conflict = propagate() ;
+            if (conflict != -1) {
+                conflicts++ ;
+                conflictsHere++ ;
+                if (decisionLevel() == 0) {
+                    return False ;
+                }
+                int backtrackLevel ;
+                analyze(conflict, learnt, backtrackLevel) ;
+                cancelUntil(backtrackLevel) ;
+                if (learnt.size() == 1) {
+                    enqueue(learnt[0], -1) ;
+                } else {
+                    int cref = newClause(learnt, true) ;
+                    clauses[cref].lbd = blockDistance(learnt) ;
+                    attach(cref) ;
+                    bumpClause(clauses[cref]) ;
+                    numLearnts++ ;
+                    enqueue(learnt[0], cref) ;
+                }
+                varInc /= 0.95 ;
+                clauseInc /= 0.999 ;
+            } else {
+                if (conflictsHere >= conflictBudget || stopRequested(stop)) {
+                    cancelUntil(0) ;
+                    return Undef ;
+                }
+                if (numLearnts >= maxLearnts + trail.size()) {
+                    reduceLearnts() ;
+                }
+                int next = -1 ;
+                while (decisionLevel() < (int) assumptions.size()) {
+                    int p = assumptions[decisionLevel()] ;
+                    if (value(p) == True) {
+                        // already implied; an empty level keeps levels and assumptions aligned
+                        trailLim.push_back((int) trail.size()) ;
+                    } else if (value(p) == False) {
+                        analyzeFinal(p) ;
+                        return False ;
+                    } else {
+                        next = p ;
+                        break ;
+                    }
+                }
+                if (next == -1) {
+                    next = pickBranch() ;
+                }
+                if (next == -1) {
+                    return True ;
+                }
+                trailLim.push_back((int) trail.size()) ;
+                enqueue(next, -1) ;
+            }
+        }
+    }
+
+    int pickBranch ()
+    {
+        while (!heap.empty()) {
+            int v = heapPop() ;
+            if (assigns[v] == Undef) {
+                return 2 * v + polarity[v] ;
+            }
+        }
+        return -1 ;
+    }
+
+    // deletes the worse half of the learnt clauses, keeping glue clauses
+    // (lbd <= 2) and clauses that are currently the reason for an assignment
+    void reduceLearnts ()
+    {
+        vector<int> candidates ;
+        for (size_t i = 0; i < clauses.size(); i++) {
+            const Clause& c = clauses[i] ;
+            bool locked = reason[var(c.lits.empty() ? 0 : c.lits[0])] == (int) i ;
+            if (c.learnt && !c.deleted && c.lbd > 2 && !locked) {
+                candidates.push_back((int) i) ;
+            }
+        }
+        sort(candidates.begin(), candidates.end(), [this] (int a, int b) {
+            if (clauses[a].lbd != clauses[b].lbd) {
+                return clauses[a].lbd > clauses[b].lbd ;
+            }
+            return clauses[a].activity < clauses[b].activity ;
+        }) ;
+        for (size_t i = 0; i < candidates.size() / 2; i++) {
+            Clause& c = clauses[candidates[i]] ;
+            c.deleted = true ;
+            vector<int>().swap(c.lits) ;
+            numLearnts-- ;
+        }
+        maxLearnts += maxLearnts / 10 ;
+    }
+
+    void bumpVar (int v)
+    {
+        if ((activity[v] += varInc) > 1e100) {
+            for (double& a : activity) {
+                a *= 1e-100 ;
+            }
+            varInc *= 1e-100 ;
+        }
+        if (heapIndex[v] >= 0) {
+            heapUp(heapIndex[v]) ;
+        }
+    }
+
+    void bumpClause (Clause& c)
+    {
+        if ((c.activity += clauseInc) > 1e20) {
+            for (Clause& other : clauses) {
+                if (other.learnt) {
+                    other.activity *= 1e-20 ;
+                }
+            }
+            clauseInc *= 1e-20 ;
+        }
+    }
+
+    // binary max-heap of variables keyed on activity
+    void heapInsert (int v)
+    {
+        heapIndex[v] = (int) heap.size() ;
+        heap.push_back(v) ;
+        heapUp(heapIndex[v]) ;
+    }
+
+    int heapPop ()
+    {
+        int top = heap[0] ;
+        heap[0] = heap.back() ;
+        heapIndex[heap[0]] = 0 ;
+        heap.pop_back() ;
+        heapIndex[top] = -1 ;
+        if (!heap.empty()) {
+            heapDown(0) ;
+        }
+        return top ;
+    }
+
+    void heapUp (int i)
+    {
+        int v = heap[i] ;
+        while (i > 0 && activity[heap[(i - 1) / 2]] < activity[v]) {
+            heap[i] = heap[(i - 1) / 2] ;
+            heapIndex[heap[i]] = i ;
+            i = (i - 1) / 2 ;
+        }
+        heap[i] = v ;
+        heapIndex[v] = i ;
+    }
+
+    void heapDown (int i)
+    {
+        int v = heap[i] ;
+        int n = (int) heap.size() ;
+        while (2 * i + 1 < n) {
+            int child = 2 * i + 1 ;
+            if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]]) {
+                child++ ;
+            }
+            if (activity[heap[child]] <= activity[v]) {
+                break ;
+            }
+            heap[i] = heap[child] ;
+            heapIndex[heap[i]] = i ;
+            i = child ;
+        }
+        heap[i] = v ;
+        heapIndex[v] = i ;
+    }
+
+    // 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ...
+    static double luby (int x)
+    {
+        int size = 1, seq = 0 ;
+        while (size < x + 1) {
+            seq++ ;
+            size = 2 * size + 1 ;
+        }
+        while (size - 1 != x) {
+            size = (size - 1) >> 1 ;
+            seq-- ;
+            x = x % size ;
+        }
+        return (double) (1 << seq) ;
+    }
+} ;
+
+// clauses over DIMACS variables 1..numVars; names[v] is the atom behind
+// variable v, empty for auxiliary variables
+struct Cnf
+{
+    int numVars ;
+    vector<vector<int> > clauses ;
+    vector<string> names ;
+
+    Cnf () : numVars(0), names(1) {}
+
+    int newVar (const string& name = "") {
+        names.push_back(name) ;
+        return ++numVars ;
+    }
+} ;
+
+// linear-size Tseitin transformation: one variable per atom and per distinct
+// binary node of the DAG, defined by three clauses each. negation flips the
+// literal instead of taking a variable, and all constants share one variable.
+// nodes already encoded by an earlier encode() call are reused
+class TseitinEncoder
+{
+public :
+    TseitinEncoder (Cnf& cnf, const FormulaStore& store) : cnf(cnf), store(store), trueVar(0) {}
+
+    // returns the literal equivalent to root
+    int encode (NodeId root)
+    {
+        vector<bool> live = store.reachable(root) ;
+        if (lits.size() <= (size_t) root) {
+            lits.resize(root + 1, 0) ;
+        }
+        for (NodeId id = 0; id <= root; id++) {
+            if (live[id] && lits[id] == 0) {
+                lits[id] = encodeNode(store[id]) ;
+            }
+        }
+        return lits[root] ;
+    }
+
+private :
+    Cnf& cnf ;
+    const FormulaStore& store ;
+    int trueVar ;
+    vector<int> lits ;     // literal of each encoded node, 0 if not encoded yet
+    vector<int> atomVars ; // variable of each atom id, 0 if not used yet
+
+    int encodeNode (const Node& n)
+    {
+        switch (n.kind) {
+            case NodeKind::Atom:
+                if ((size_t) n.a >= atomVars.size()) {
+                    atomVars.resize(n.a + 1, 0) ;
+                }
+                if (atomVars[n.a] == 0) {
+                    atomVars[n.a] = cnf.newVar(store.symbols.name(n.a)) ;
+                }
+                return atomVars[n.a] ;
+            case NodeKind::Const:
+                if (trueVar == 0) {
+                    trueVar = cnf.newVar() ;
+                    cnf.clauses.push_back({ trueVar }) ;
+                }
+                return n.a ? trueVar : -trueVar ;
+            case NodeKind::Neg:
+                return -lits[n.a] ;
+            default:
+                break ;
+        }
+
+        int a = lits[n.a] ;
+        int b = lits[n.b] ;
+        int g = cnf.newVar() ;
+        switch (n.kind) {
+            case NodeKind::And:
+                cnf.clauses.push_back({ -g, a }) ;
+                cnf.clauses.push_back({ -g, b }) ;
+                cnf.clauses.push_back({ g, -a, -b }) ;
+                break ;
+            case NodeKind::Or:
+                cnf.clauses.push_back({ g, -a }) ;
+                cnf.clauses.push_back({ g, -b }) ;
+                cnf.clauses.push_back({ -g, a, b }) ;
+                break ;
+            default:
+                cnf.clauses.push_back({ g, a }) ;
+                cnf.clauses.push_back({ g, -b }) ;
+                cnf.clauses.push_back({ -g, -a, b }) ;
+                break ;
+        }
+        return g ;
+    }
+} ;
+
+// CNF satisfiable iff root is (or iff !root is, when negate is set)
+Cnf toCnf (const FormulaStore& store, NodeId root, bool negate = false)
+{
+    ProfileScope scope("tseitin") ;
+    Cnf cnf ;
+    TseitinEncoder encoder(cnf, store) ;
+    int lit = encoder.encode(root) ;
+    cnf.clauses.push_back({ negate ? -lit : lit }) ;
+    return cnf ;
+}
+
+// atom names are kept as "c var <v> <name>" comment lines
+void writeDimacs (ostream& out, const Cnf& cnf)
+{
+    for (int v = 1; v <= cnf.numVars; v++) {
+        if (!cnf.names[v].empty()) {
+            out << "c var " << v << " " << cnf.names[v] << "\n" ;
+        }
+    }
+    out << "p cnf " << cnf.numVars << " " << cnf.clauses.size() << "\n" ;
+    for (const vector<int>& clause : cnf.clauses) {
+        for (int lit : clause) {
+            out << lit << " " ;
+        }
+        out << "0\n" ;
+    }
+}
+
+// any line starting with 'c' is a comment; "c var <n> <name>" comments
+// name variables. declaredClauses, if given, receives the clause count of
+// the header, which may differ from the clauses actually read
+Cnf readDimacs (istream& in, size_t* declaredClauses = nullptr)
+{
+    Cnf cnf ;
+    size_t numClauses = 0 ;
+    bool header = false ;
+    vector<int> clause ;
+    string word ;
+
+    while (in >> word) {
+        if (word[0] == 'c' && word != "c") {
+            string rest ;
+            getline(in, rest) ;
+        } else if (word == "c") {
+            string line ;
+            getline(in, line) ;
+            istringstream comment(line) ;
+            string tag, name ;
+            int v ;
+            if (comment >> tag >> v >> name && tag == "var" && v >= 1) {
+                if ((size_t) v >= cnf.names.size()) {
+                    cnf.names.resize(v + 1) ;
+                }
+                cnf.names[v] = name ;
+            }
+        } else if (word == "p") {
+            string format ;
+            if (!(in >> format >> cnf.numVars >> numClauses) || format != "cnf" || cnf.numVars < 0) {
+                throw runtime_error("Malformed DIMACS header") ;
+            }
+            header = true ;
+        } else if (word == "%") {
+            break ; // end marker used by the SATLIB benchmark files
+        } else {
+            if (!header) {
+                throw runtime_error("DIMACS clause before 'p cnf' header") ;
+            }
+            char* end ;
+            long value = strtol(word.c_str(), &end, 10) ;
+            if (*end != '\0') {
+                throw runtime_error("Unexpected DIMACS token: " + word) ;
+            }
+            if (value > cnf.numVars || value < -(long) cnf.numVars) {
+                throw runtime_error("DIMACS literal out of range: " + word) ;
+            }
+            int lit = (int) value ;
+            if (lit == 0) {
+                cnf.clauses.push_back(clause) ;
+                clause.clear() ;
+            } else {
+                clause.push_back(lit) ;
+            }
+        }
+    }
+    if (!header) {
+        throw runtime_error("Missing DIMACS 'p cnf' header") ;
+    }
+    if (!clause.empty()) {
+        cnf.clauses.push_back(clause) ;
+    }
+    if (declaredClauses) {
+        *declaredClauses = numClauses ;
+    }
+    cnf.names.resize(cnf.numVars + 1) ;
+    return cnf ;
+}
+
+void loadCnf (CdclSolver& solver, const Cnf& cnf)
+{
+    while (solver.numVars() < cnf.numVars) {
+        solver.newVar() ;
+    }
+    for (const vector<int>& clause : cnf.clauses) {
+        solver.addClause(clause) ;
+    }
+}
+
+// budget and tuning of a local search run; the search gives up on
+// whichever limit it reaches first
+struct LocalSearchOptions
+{
+    unsigned threads = 1 ;
+    uint64_t maxFlips = 0 ;        // per worker; 0 scales it with the CNF, see flipBudget()
+    double maxSeconds = 1.0 ;
+    uint64_t seed = 1 ;
+    double cb = 2.3 ;              // exponent of the ProbSAT break weight
+} ;
+
+// ProbSAT over a CNF: start from a random assignment, pick a random
+// falsified clause, and flip one of its variables with probability
+// proportional to (1 + break)^-cb, where break is the number of clauses
+// the flip would falsify. break counts are kept incrementally: every
+// clause tracks how many of its literals are true and, when that is one,
+// which variable is critical, so a flip touches only the occurrence lists
+// of the flipped variable. workers run the same search from different
+// seeds and the first to satisfy every clause stops the rest. incomplete:
+// false only means no model was found within the budget
+class LocalSearch
+{
+public :
+    explicit LocalSearch (const Cnf& cnf) : numVars(cnf.numVars), totalFlips(0), stop(nullptr) {
+        vector<vector<int> > occurs(2 * numVars) ;
+        for (const vector<int>& dimacs : cnf.clauses) {
+            vector<int> lits ;
+            for (int d : dimacs) {
+                lits.push_back(d > 0 ? 2 * (d - 1) : 2 * (-d - 1) + 1) ;
+            }
+            sort(lits.begin(), lits.end()) ;
+            lits.erase(unique(lits.begin(), lits.end()), lits.end()) ;
+            bool tautology = false ;
+            for (size_t i = 1; i < lits.size(); i++) {
+                tautology = tautology || lits[i] == (lits[i - 1] ^ 1) ;
+            }
+            if (tautology) {
+                continue ;
+            }
+            int c = (int) clauseStart.size() ;
+            clauseStart.push_back((int) clauseLits.size()) ;
+            for (int lit : lits) {
+                clauseLits.push_back(lit) ;
+                occurs[lit].push_back(c) ;
+            }
+        }
+        clauseStart.push_back((int) clauseLits.size()) ;
+        for (const vector<int>& list : occurs) {
+            occurStart.push_back((int) occurClauses.size()) ;
+            occurClauses.insert(occurClauses.end(), list.begin(), list.end()) ;
+        }
+        occurStart.push_back((int) occurClauses.size()) ;
+    }
+
+    bool solve (const LocalSearchOptions& options)
+    {
+        ProfileScope scope("localSearch") ;
+        model.clear() ;
+        totalFlips = 0 ;
+        for (size_t c = 0; c + 1 < clauseStart.size(); c++) {
+            if (clauseStart[c] == clauseStart[c + 1]) {
+                return false ; // an empty clause, no model exists
+            }
+        }
+        atomic<bool> found(false) ;
+        vector<thread> workers ;
+        unsigned n = max(options.threads, 1u) ;
+        for (unsigned w = 1; w < n; w++) {
+            workers.push_back(thread(&LocalSearch::work, this, cref(options), options.seed + 0x9E3779B97F4A7C15ULL * w, ref(found))) ;
+        }
+        work(options, options.seed, found) ; // the caller is worker 0
+        for (thread& t : workers) {
+            t.join() ;
+        }
+        Profiler::global().count(Profiler::Assignments, totalFlips) ;
+        if (!found && stopRequested(stop)) {
+            throw Cancelled() ;
+        }
+        return found ;
+    }
+
+    // checked every 1024 flips
+    void setStop (const atomic<bool>* flag)
+    {
+        stop = flag ;
+    }
+
+    // value of a DIMACS variable in the model of the last successful solve()
+    bool modelValue (int var) const
+    {
+        return model[var - 1] ;
+    }
+
+    uint64_t flips () const
+    {
+        return totalFlips ;
+    }
+
+private :
+    int numVars ;
+    vector<int> clauseStart ;  // literals of clause c are clauseLits[clauseStart[c], clauseStart[c + 1])
+    vector<int> clauseLits ;   // 2 * var + sign, 0-based vars
+    vector<int> occurStart ;   // clauses containing literal l, in the same layout
+    vector<int> occurClauses ;
+    mutex lock ;
+    vector<bool> model ;
+    atomic<uint64_t> totalFlips ;
+    const atomic<bool>* stop ;
+
+    // one worker's state
+    struct Walk {
+        vector<char> value ;
+        vector<int> numTrue ;
+        vector<int> critical ;  // the only true variable of a clause with numTrue == 1
+        vector<int> breaks ;
+        vector<int> unsat ;     // falsified clauses, in any order
+        vector<int> unsatIndex ;
+    } ;
+
+    bool isTrue (const Walk& walk, int lit) const {
+        return walk.value[lit >> 1] != (lit & 1) ;
+    }
+
+    void makeUnsat (Walk& walk, int c) {
+        walk.unsatIndex[c] = (int) walk.unsat.size() ;
+        walk.unsat.push_back(c) ;
+    }
+
+    void makeSat (Walk& walk, int c) {
+        int last = walk.unsat.back() ;
+        walk.unsat[walk.unsatIndex[c]] = last ;
+        walk.unsatIndex[last] = walk.unsatIndex[c] ;
+        walk.unsat.pop_back() ;
+    }
+
+    void flip (Walk& walk, int v) {
+        walk.value[v] = !walk.value[v] ;
+        int madeTrue = 2 * v + !walk.value[v] ;
+        for (int i = occurStart[madeTrue]; i < occurStart[madeTrue + 1]; i++) {
+            int c = occurClauses[i] ;
+            int count = ++walk.numTrue[c] ;
+            if (count == 1) {
+                makeSat(walk, c) ;
+                walk.critical[c] = v ;
+                walk.breaks[v]++ ;
+            } else if (count == 2) {
+                walk.breaks[walk.critical[c]]-- ;
+            }
+        }
+        int madeFalse = madeTrue ^ 1 ;
+        for (int i = occurStart[madeFalse]; i < occurStart[madeFalse + 1]; i++) {
+            int c = occurClauses[i] ;
+            int count = --walk.numTrue[c] ;
+            if (count == 0) {
+                makeUnsat(walk, c) ;
+                walk.breaks[v]-- ;
+            } else if (count == 1) {
+                for (int k = clauseStart[c]; k < clauseStart[c + 1]; k++) {
+                    if (isTrue(walk, clauseLits[k])) {
+                        walk.critical[c] = clauseLits[k] >> 1 ;
+                        walk.breaks[walk.critical[c]]++ ;
+                        break ;
+                    }
+                }
+            }
+        }
+    }
+
+    // local search cannot prove a CNF unsatisfiable, so without an explicit
+    // budget it gets a short one, kFlipsPerVar flips per variable up to
+    // kMaxAutoFlips, before the caller falls back to something complete
+    static const uint64_t kFlipsPerVar = 100 ;
+    static const uint64_t kMaxAutoFlips = 1000000 ;
+
+    uint64_t flipBudget (const LocalSearchOptions& options) const
+    {
+        if (options.maxFlips) {
+            return options.maxFlips ;
+        }
+        return min<uint64_t>(kMaxAutoFlips, 1024 + kFlipsPerVar * (uint64_t) numVars) ;
+    }
+
+    void work (const LocalSearchOptions& options, uint64_t seed, atomic<bool>& found)
+    {
+        typedef chrono::steady_clock Clock ;
+        Clock::time_point deadline = Clock::now() + chrono::microseconds((int64_t) (options.maxSeconds * 1e6)) ;
+        mt19937_64 rng(seed) ;
+        size_t numClauses = clauseStart.size() - 1 ;
+
+        Walk walk ;
+        walk.value.resize(numVars) ;
+        for (char& x : walk.value) {
+            x = (char) (rng() & 1) ;
+        }
+        walk.numTrue.assign(numClauses, 0) ;
+        walk.critical.assign(numClauses, -1) ;
+        walk.breaks.assign(numVars, 0) ;
+        walk.unsatIndex.assign(numClauses, -1) ;
+        for (size_t c = 0; c < numClauses; c++) {
+            for (int k = clauseStart[c]; k < clauseStart[c + 1]; k++) {
+                if (isTrue(walk, clauseLits[k])) {
+                    walk.numTrue[c]++ ;
+                    walk.critical[c] = clauseLits[k] >> 1 ;
+                }
+            }
+            if (walk.numTrue[c] == 0) {
+                makeUnsat(walk, (int) c) ;
+            } else if (walk.numTrue[c] == 1) {
+                walk.breaks[walk.critical[c]]++ ;
+            }
+        }
+
+        // weights for small break counts, the rest computed on demand
+        double weights[64] ;
+        for (int b = 0; b < 64; b++) {
+            weights[b] = pow(1.0 + b, -options.cb) ;
+        }
+        vector<double> probs ;
+        uniform_real_distribution<double> unit(0, 1) ;
+
+        uint64_t flips = 0 ;
+        uint64_t budget = flipBudget(options) ;
+        while (!walk.unsat.empty() && flips < budget) {
+            if ((flips & 1023) == 0 && (found || stopRequested(stop) || Clock::now() > deadline)) {
+                break ;
+            }
+            int c = walk.unsat[rng() % walk.unsat.size()] ;
+            double sum = 0 ;
+            probs.clear() ;
+            for (int k = clauseStart[c]; k < clauseStart[c + 1]; k++) {
+                int b = walk.breaks[clauseLits[k] >> 1] ;
+                probs.push_back(b < 64 ? weights[b] : pow(1.0 + b, -options.cb)) ;
+                sum += probs.back() ;
+            }
+            double r = unit(rng) * sum ;
+            int k = clauseStart[c] ;
+            for (size_t i = 0; i + 1 < probs.size() && r >= probs[i]; i++) {
+                r -= probs[i] ;
+                k++ ;
+            }
+            flip(walk, clauseLits[k] >> 1) ;
+            flips++ ;
+        }
+        totalFlips += flips ;
+
+        if (walk.unsat.empty() && !found.exchange(true)) {
+            lock_guard<mutex> guard(lock) ;
+            model.assign(walk.value.begin(), walk.value.end()) ;
+        }
+    }
+} ;
+
+const uint64_t LocalSearch::kFlipsPerVar ;
+const uint64_t LocalSearch::kMaxAutoFlips ;
+
+// answers many related questions about one base formula without starting
+// over. formulas are parsed into one store, every constraint and
+// assumption goes through one Tseitin encoder whose per-node literals live
+// as long as the solver, and the CDCL solver keeps its learnt clauses,
+// activities and saved phases from one solve() to the next. a subformula
+// encoded once costs nothing when it shows up again
+class IncrementalSolver
+{
+public :
+    IncrementalSolver () : encoder(cnf, store) {}
+
+    IncrementalSolver (const IncrementalSolver&) = delete ;
+    IncrementalSolver& operator= (const IncrementalSolver&) = delete ;
+
+    // for building constraints directly in the solver's store
+    FormulaStore& formulas ()
+    {
+        return store ;
+    }
+
+    NodeId parse (const string& text)
+    {
+        return parseFormula(text, store) ;
+    }
+
+    // formula holds in every later solve(); false once the constraints
+    // contradict each other
+    bool addConstraint (NodeId formula)
+    {
+        return solver.addClause({ encode(formula) }) ;
+    }
+
+    bool addConstraint (const string& text)
+    {
+        return addConstraint(parse(text)) ;
+    }
+
+    // satisfiable together with the constraints while every assumed
+    // formula holds; the assumptions are forgotten afterwards
+    bool solve (const vector<NodeId>& assumed = vector<NodeId>())
+    {
+        vector<int> lits ;
+        for (NodeId formula : assumed) {
+            lits.push_back(encode(formula)) ;
+        }
+        bool satisfiable = solver.solve(lits) ;
+        failed.clear() ;
+        for (int lit : solver.failedAssumptions()) {
+            for (size_t i = 0; i < lits.size(); i++) {
+                if (lits[i] == lit && find(failed.begin(), failed.end(), assumed[i]) == failed.end()) {
+                    failed.push_back(assumed[i]) ;
+                }
+            }
+        }
+        return satisfiable ;
+    }
+
+    // after an unsatisfiable solve(): assumed formulas that cannot hold
+    // together with the constraints, empty if the constraints alone fail
+    const vector<NodeId>& failedAssumptions () const
+    {
+        return failed ;
+    }
+
+    // the atoms the last solve() assigned, empty unless it was satisfiable;
+    // atoms first encoded after it are left out
+    map<string, bool> model () const
+    {
+        map<string, bool> result ;
+        for (int v = 1; v <= cnf.numVars && v <= solver.modelVars(); v++) {
+            if (!cnf.names[v].empty()) {
+                result[cnf.names[v]] = solver.modelValue(v) ;
+            }
+        }
+        return result ;
+    }
+
+private :
+    FormulaStore store ;
+    Cnf cnf ;
+    TseitinEncoder encoder ;
+    CdclSolver solver ;
+    vector<NodeId> failed ;
+
+    // new variables and clauses go straight to the solver, cnf only keeps
+    // the variable names
+    int encode (NodeId formula)
+    {
+        int lit = encoder.encode(formula) ;
+        while (solver.numVars() < cnf.numVars) {
+            solver.newVar() ;
+        }
+        for (const vector<int>& clause : cnf.clauses) {
+            solver.addClause(clause) ;
+        }
+        cnf.clauses.clear() ;
+        return lit ;
+    }
+} ;
+
+// reduced ordered BDDs with complemented edges. an edge is a node index
+// shifted left once, with the low bit meaning "negated"; node 0 is the
+// constant-true terminal, so edge 0 is true and edge 1 is false. hi edges
+// are always regular, which keeps every function canonical: two formulas
+// are equivalent iff they build the same edge. variables are ordered by
+// their index, which follows the order atom names are first seen, and are
+// keyed by name so formulas from different stores share one manager.
+// nodes come from a hash-based unique table, ite() results are kept in a
+// lossy computed cache, and unreferenced nodes are reclaimed by gc()
+class BddManager
+{
+public :
+    typedef uint32_t Edge ;
+
+    static const Edge True = 0 ;
+    static const Edge False = 1 ;
+
+    BddManager () : freeList(0), freeCount(0), gcThreshold(1 << 16), cache(1 << 16) {
+        BddNode terminal = { kTerminalVar, True, True, 0 } ;
+        nodes.push_back(terminal) ;
+        refs.push_back(1) ;
+        buckets.assign(1 << 12, 0) ;
+        clearCache() ;
+    }
+
+    int varFor (const string& name) {
+        return vars.intern(name) ;
+    }
+
+    Edge var (int v) {
+        return mk(v, False, True) ;
+    }
+
+    Edge ite (Edge f, Edge g, Edge h) ;
+
+    Edge apply (NodeKind kind, Edge f, Edge g) {
+        switch (kind) {
+            case NodeKind::And: return ite(f, g, False) ;
+            case NodeKind::Or: return ite(f, True, g) ;
+            case NodeKind::Imp: return ite(f, g, True) ;
+            default: throw runtime_error("Not a binary node.") ;
+        }
+    }
+
+    // builds the BDD of root; the result is referenced and must be deref'd
+    // by the caller. a raised stop flag, polled every few thousand ite()
+    // steps, abandons the build with Cancelled and releases what it held
+    Edge build (const FormulaStore& store, NodeId root, const atomic<bool>* stop = nullptr) ;
+
+    bool equivalent (Edge f, Edge g) const {
+        return f == g ;
+    }
+
+    // number of assignments to the given variables satisfying f; vars must
+    // contain every variable f depends on
+    ModelCount satCount (Edge f, const vector<int>& vars) ;
+
+    // the variables along one path from f to true, low branch first; every
+    // non-constant edge has such a path. variables off the path are free
+    map<string, bool> anyModel (Edge f) const {
+        map<string, bool> path ;
+        while (f >> 1 != 0) {
+            bool high = lo(f) == False ;
+            path[vars.name(topVar(f))] = high ;
+            f = high ? hi(f) : lo(f) ;
+        }
+        return path ;
+    }
+
+    // edges held outside the manager must be referenced to survive gc()
+    void ref (Edge e) {
+        refs[e >> 1]++ ;
+    }
+
+    void deref (Edge e) {
+        refs[e >> 1]-- ;
+    }
+
+    // frees every node not reachable from a referenced edge
+    void gc () ;
+
+    size_t liveNodes () const {
+        return nodes.size() - freeCount ;
+    }
+
+private :
+    static const int kTerminalVar = 0x7fffffff ;
+
+    struct BddNode {
+        int var ;
+        Edge lo ;
+        Edge hi ;
+        uint32_t next ; // unique-table chain, or free-list link
+    } ;
+
+    struct CacheEntry {
+        Edge f, g, h, result ;
+    } ;
+
+    SymbolTable vars ;
+    vector<BddNode> nodes ;
+    vector<uint32_t> refs ;
+    vector<uint32_t> buckets ; // heads of the unique-table chains, 0 if empty
+    uint32_t freeList ;
+    size_t freeCount ;
+    size_t gcThreshold ;
+    vector<CacheEntry> cache ;
+    const atomic<bool>* stop = nullptr ; // set during build()
+    uint32_t steps = 0 ;
+
+    int topVar (Edge e) const {
+        return nodes[e >> 1].var ;
+    }
+
+    Edge lo (Edge e) const {
+        return nodes[e >> 1].lo ^ (e & 1) ;
+    }
+
+    Edge hi (Edge e) const {
+        return nodes[e >> 1].hi ^ (e & 1) ;
+    }
+
+    static size_t hash (int var, Edge lo, Edge hi) {
+        uint64_t h = ((uint64_t) lo << 32 | hi) * 0x9E3779B97F4A7C15ULL + (uint64_t) var * 0xC2B2AE3D27D4EB4FULL ;
+        return (size_t) (h ^ (h >> 31)) ;
+    }
+
+    Edge mk (int var, Edge lo, Edge hi) ;
+    void rehash (size_t size) ;
+
+    void clearCache () {
+        CacheEntry empty = { 1, 1, 1, 1 } ; // ite(false, ...) is never cached
+        fill(cache.begin(), cache.end(), empty) ;
+    }
+} ;
+
+const BddManager::Edge BddManager::True ;
+const BddManager::Edge BddManager::False ;
+const int BddManager::kTerminalVar ;
+
+BddManager::Edge BddManager::mk (int var, Edge lo, Edge hi)
+{
+    if (lo == hi) {
+        return lo ;
+    }
+    if (hi & 1) {
+        return mk(var, lo ^ 1, hi ^ 1) ^ 1 ;
+    }
+
+    size_t bucket = hash(var, lo, hi) & (buckets.size() - 1) ;
+    for (uint32_t i = buckets[bucket]; i != 0; i = nodes[i].next) {
+        if (nodes[i].var == var && nodes[i].lo == lo && nodes[i].hi == hi) {
+            return i << 1 ;
+        }
+    }
+
+    uint32_t index ;
+    if (freeList != 0) {
+        index = freeList ;
+        freeList = nodes[index].next ;
+        freeCount-- ;
+    } else {
+        index = (uint32_t) nodes.size() ;
+        nodes.push_back(BddNode()) ;
+        refs.push_back(0) ;
+    }
+    BddNode n = { var, lo, hi, buckets[bucket] } ;
+    nodes[index] = n ;
+    buckets[bucket] = index ;
+
+    if (liveNodes() > 2 * buckets.size()) {
+        rehash(2 * buckets.size()) ;
+    }
+    return index << 1 ;
+}
+
+void BddManager::rehash (size_t size)
+{
+    buckets.assign(size, 0) ;
+    for (uint32_t i = 1; i < nodes.size(); i++) {
+        if (nodes[i].var < 0) {
+            continue ; // on the free list
+        }
+        size_t bucket = hash(nodes[i].var, nodes[i].lo, nodes[i].hi) & (size - 1) ;
+        nodes[i].next = buckets[bucket] ;
+        buckets[bucket] = i ;
+    }
+}
+
+BddManager::Edge BddManager::ite (Edge f, Edge g, Edge h)
+{
+    if (f == True || g == h) return g ;
+    if (f == False) return h ;
+    if (g == True && h == False) return f ;
+    if (g == False && h == True) return f ^ 1 ;
+
+    // normalize so f and g are regular edges; the result is negated instead
+    if (f & 1) {
+        f ^= 1 ;
+        swap(g, h) ;
+    }
+    Edge negate = 0 ;
+    if (g & 1) {
+        g ^= 1 ;
+        h ^= 1 ;
+        negate = 1 ;
+    }
+
+    size_t slot = (hash(f, g, h) ^ h) & (cache.size() - 1) ;
+    if (cache[slot].f == f && cache[slot].g == g && cache[slot].h == h) {
+        return cache[slot].result ^ negate ;
+    }
+
+    if ((++steps & 4095) == 0 && stopRequested(stop)) {
+        throw Cancelled() ;
+    }
+    int v = min(topVar(f), min(topVar(g), topVar(h))) ;
+    Edge f0 = topVar(f) == v ? lo(f) : f, f1 = topVar(f) == v ? hi(f) : f ;
+    Edge g0 = topVar(g) == v ? lo(g) : g, g1 = topVar(g) == v ? hi(g) : g ;
+    Edge h0 = topVar(h) == v ? lo(h) : h, h1 = topVar(h) == v ? hi(h) : h ;
+    Edge result = mk(v, ite(f0, g0, h0), ite(f1, g1, h1)) ;
+
+    CacheEntry entry = { f, g, h, result } ;
+    cache[slot] = entry ;
+    return result ^ negate ;
+}
+
+BddManager::Edge BddManager::build (const FormulaStore& store, NodeId root, const atomic<bool>* stop)
+{
+    ProfileScope scope("bdd") ;
+    vector<bool> live = store.reachable(root) ;
+    vector<Edge> memo(root + 1) ;
+    vector<NodeId> held ;
+
+    // every partial result stays referenced until the root is built, so
+    // collecting garbage between nodes is safe
+    this->stop = stop ;
+    try {
+        for (NodeId id = 0; id <= root; id++) {
+            if (!live[id]) {
+                continue ;
+            }
+            const Node& n = store[id] ;
+            Edge e ;
+            switch (n.kind) {
+                case NodeKind::Atom: e = var(varFor(store.symbols.name(n.a))) ; break ;
+                case NodeKind::Const: e = n.a ? True : False ; break ;
+                case NodeKind::Neg: e = memo[n.a] ^ 1 ; break ;
+                default: e = apply(n.kind, memo[n.a], memo[n.b]) ; break ;
+            }
+            memo[id] = e ;
+            ref(e) ;
+            held.push_back(id) ;
+            if (liveNodes() > gcThreshold) {
+                gc() ;
+            }
+        }
+    } catch (...) {
+        for (NodeId id : held) {
+            deref(memo[id]) ;
+        }
+        this->stop = nullptr ;
+        throw ;
+    }
+    this->stop = nullptr ;
+
+    Edge result = memo[root] ;
+    ref(result) ;
+    for (NodeId id : held) {
+        deref(memo[id]) ;
+    }
+    return result ;
+}
+
+ModelCount BddManager::satCount (Edge f, const vector<int>& vars)
+{
+    // rank[v] is the position of v among vars, the terminal ranks last
+    vector<int> sorted(vars) ;
+    sort(sorted.begin(), sorted.end()) ;
+    unordered_map<int, int> rank ;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        rank[sorted[i]] = (int) i ;
+    }
+    int total = (int) sorted.size() ;
+    rank[kTerminalVar] = total ;
+
+    // count[node] is the number of models of the regular edge to node over
+    // the variables ranked from the node down; a negated edge has the
+    // complement count within the same subspace
+    unordered_map<uint32_t, ModelCount> count ;
+    count[0] = ModelCount(1) ;
+    vector<uint32_t> stack(1, f >> 1) ;
+    while (!stack.empty()) {
+        uint32_t i = stack.back() ;
+        if (count.count(i)) {
+            stack.pop_back() ;
+            continue ;
+        }
+        const BddNode& n = nodes[i] ;
+        if (!count.count(n.lo >> 1) || !count.count(n.hi >> 1)) {
+            stack.push_back(n.lo >> 1) ;
+            stack.push_back(n.hi >> 1) ;
+            continue ;
+        }
+        int r = rank.at(n.var) ;
+        ModelCount sum ;
+        for (Edge child : { n.lo, n.hi }) {
+            int childRank = rank.at(topVar(child)) ;
+            ModelCount c = count[child >> 1] ;
+            if (child & 1) {
+                ModelCount all(1) ;
+                all <<= total - childRank ;
+                c = all -= c ;
+            }
+            c <<= childRank - r - 1 ;
+            sum += c ;
+        }
+        count[i] = sum ;
+        stack.pop_back() ;
+    }
+
+    int fRank = rank.at(topVar(f)) ;
+    ModelCount c = count[f >> 1] ;
+    if (f & 1) {
+        ModelCount all(1) ;
+        all <<= total - fRank ;
+        c = all -= c ;
+    }
+    c <<= fRank ;
+    return c ;
+}
+
+void BddManager::gc ()
+{
+    vector<bool> marked(nodes.size()) ;
+    vector<uint32_t> stack ;
+    marked[0] = true ;
+    for (uint32_t i = 1; i < nodes.size(); i++) {
+        if (refs[i] > 0 && nodes[i].var >= 0) {
+            stack.push_back(i) ;
+        }
+    }
+    while (!stack.empty()) {
+        uint32_t i = stack.back() ;
+        stack.pop_back() ;
+        if (marked[i]) {
+            continue ;
+        }
+        marked[i] = true ;
+        stack.push_back(nodes[i].lo >> 1) ;
+        stack.push_back(nodes[i].hi >> 1) ;
+    }
+
+    for (uint32_t i = 1; i < nodes.size(); i++) {
+        if (!marked[i] && nodes[i].var >= 0) {
+            nodes[i].var = -1 ;
+            nodes[i].next = freeList ;
+            freeList = i ;
+            freeCount++ ;
+        }
+    }
+    rehash(buckets.size()) ;
+    clearCache() ;
+
+    // collect less often when most nodes survive
+    if (liveNodes() > gcThreshold / 2) {
+        gcThreshold *= 2 ;
+    }
+}
+
+enum class Strategy { TruthTable, GrayCode, BitSliced, Parallel, Jit, Cdcl, LocalSearch, Bdd, Portfolio } ;
+
+class Portfolio ;
+
+// everything one pass over the truth table says about a formula. the
+// examples map each atom of the formula to its value; witness is empty
+// when the formula is unsatisfiable, counterexample when it is valid
+struct Analysis
+{
+    bool satisfiable ;
+    bool valid ;
+    ModelCount models ;
+    map<string, bool> witness ;
+    map<string, bool> counterexample ;
+} ;
+
+class FormulaInterpreter 
+{
+public :
+    // store must outlive the interpreter
+    FormulaInterpreter (const FormulaStore& store, NodeId root, Strategy strategy = Strategy::TruthTable)
+        : store(store), root(root), strategy(strategy), threads(thread::hardware_concurrency()) {
+        init() ;
+    }
+
+    // trees built from the Formula classes are copied into a private store
+    FormulaInterpreter (shared_ptr<Formula> formula, Strategy strategy = Strategy::TruthTable)
+        : owned(new FormulaStore), store(*owned), root(owned->intern(formula)), strategy(strategy),
+          threads(thread::hardware_concurrency()) {
+        init() ;
+    }
+
+    ~FormulaInterpreter ()
+    {
+        releaseBdd() ;
+    }
+
+    // worker count for Strategy::Parallel, Jit and LocalSearch, defaults to the number of cores
+    void setThreads (unsigned n)
+    {
+        threads = n ;
+    }
+
+    bool isSatisfiable ()
+    {
+        if (haveAnalysis) {
+            return analysis.satisfiable ;
+        }
+        ProfileScope scope("isSatisfiable") ;
+        if (strategy == Strategy::Portfolio) {
+            return race(false) ;
+        }
+        if (strategy == Strategy::Jit && JitEvaluator::supported()) {
+            JitEvaluator jit(store, root) ;
+            jit.setStop(stop) ;
+            return jit.anySet(threads) ;
+        }
+        if (strategy == Strategy::BitSliced || strategy == Strategy::Jit) {
+            return bitSliced().anySet() ;
+        }
+        if (strategy == Strategy::Parallel) {
+            return bitSliced().anySetParallel(threads) ;
+        }
+        if (strategy == Strategy::Cdcl) {
+            return solveWithCdcl(false) ;
+        }
+        if (strategy == Strategy::LocalSearch) {
+            return solveWithLocalSearch(false) ;
+        }
+        if (strategy == Strategy::Bdd) {
+            return bdd() != BddManager::False ;
+        }
+        if (strategy == Strategy::GrayCode) {
+            return grayFind(true) ;
+        }
+        vector<char> assignment(store.symbols.size(), kUnknown) ;
+        evaluations = 0 ;
+        bool found = tryAssignments(0, assignment) ;
+        reportWork(evaluations, evaluations * order.size()) ;
+        return found ;
+    }
+
+    // number of assignments to the formula's atoms that satisfy it; counted
+    // over the bit-sliced truth table, on all worker threads in parallel
+    // mode. the BDD counts under Strategy::Bdd, and for every strategy once
+    // the formula has too many atoms for a table
+    ModelCount countModels ()
+    {
+        if (haveAnalysis) {
+            return analysis.models ;
+        }
+        ProfileScope scope("countModels") ;
+        if (strategy == Strategy::Bdd || atoms.size() > TruthTableLayout::kMaxAtoms) {
+            BddManager::Edge f = bdd() ; // creates the manager on first use
+            vector<int> vars ;
+            for (int atom : atoms) {
+                vars.push_back(bddManager->varFor(store.symbols.name(atom))) ;
+            }
+            return bddManager->satCount(f, vars) ;
+        }
+        if (strategy == Strategy::Jit && JitEvaluator::supported()) {
+            JitEvaluator jit(store, root) ;
+            jit.setStop(stop) ;
+            return jit.countSet(threads) ;
+        }
+        return bitSliced().countSet(strategy == Strategy::Parallel ? threads : 1) ;
+    }
+
+    // satisfiability, validity, the model count and an example of each from
+    // a single pass over the bit-sliced truth table, on all worker threads
+    // in parallel mode. the result is cached, and with keepTruthTable so is
+    // the table itself, which then answers evaluate() by lookup. once it
+    // has run, isSatisfiable(), isValid() and countModels() answer from it.
+    // formulas with too many atoms for a table are analyzed by the BDD
+    // under Strategy::Bdd and by CDCL otherwise
+    Analysis analyze (bool keepTruthTable = false)
+    {
+        if (haveAnalysis && (haveTable || !keepTruthTable)) {
+            return analysis ;
+        }
+        ProfileScope scope("analyze") ;
+        if (!keepTruthTable && atoms.size() > TruthTableLayout::kMaxAtoms) {
+            analyzeWithoutTable() ;
+            return analysis ;
+        }
+        BitSlicedEvaluator evaluator = bitSliced() ;
+        BitSlicedEvaluator::TableScan scan =
+            evaluator.scan(strategy == Strategy::Parallel ? threads : 1, keepTruthTable ? &truthTable : nullptr) ;
+
+        analysis.satisfiable = scan.firstSet >= 0 ;
+        analysis.valid = scan.firstClear < 0 ;
+        analysis.models = scan.count ;
+        analysis.witness = assignmentAt(evaluator, scan.firstSet) ;
+        analysis.counterexample = assignmentAt(evaluator, scan.firstClear) ;
+        haveAnalysis = true ;
+
+        if (keepTruthTable) {
+            tableAtoms.clear() ;
+            for (size_t k = 0; k < evaluator.atomCount(); k++) {
+                tableAtoms.push_back(evaluator.atomId(k)) ;
+            }
+            haveTable = true ;
+        }
+        return analysis ;
+    }
+
+    // value of the formula under assignment, atoms it leaves out being false
+    bool evaluate (const map<string, bool>& assignment)
+    {
+        vector<bool> bits(store.symbols.size()) ;
+        for (const auto& entry : assignment) {
+            int atom = store.symbols.find(entry.first) ;
+            if (atom >= 0) {
+                bits[atom] = entry.second ;
+            }
+        }
+        if (!haveTable) {
+            return evaluate(bits) ;
+        }
+        uint64_t index = 0 ;
+        for (size_t k = 0; k < tableAtoms.size(); k++) {
+            index |= (uint64_t) bits[tableAtoms[k]] << k ;
+        }
+        return (truthTable[index / 64] >> (index % 64)) & 1 ;
+    }
+
+    // a set of literals every completion of which satisfies the formula:
+    // the cached witness with each literal dropped whose removal still
+    // leaves the formula true in three-valued logic. empty for a valid
+    // formula, and also for an unsatisfiable one
+    map<string, bool> satisfyingCube ()
+    {
+        Analysis result = analyze() ;
+        map<string, bool> cube ;
+        if (!result.satisfiable) {
+            return cube ;
+        }
+        vector<char> partial(store.symbols.size(), kUnknown) ;
+        for (const auto& entry : result.witness) {
+            partial[store.symbols.find(entry.first)] = entry.second ;
+        }
+        for (int atom : atoms) {
+            char value = partial[atom] ;
+            partial[atom] = kUnknown ;
+            if (evaluatePartial(partial) != 1) {
+                partial[atom] = value ;
+            }
+        }
+        for (int atom : atoms) {
+            if (partial[atom] != kUnknown) {
+                cube[store.symbols.name(atom)] = partial[atom] == 1 ;
+            }
+        }
+        return cube ;
+    }
+
+    // budget of Strategy::LocalSearch; its worker count follows setThreads
+    void setLocalSearch (const LocalSearchOptions& options)
+    {
+        localSearch = options ;
+    }
+
+    // Strategy::Portfolio races the engines of this portfolio, a default
+    // one if none is set; sharing it adds up the win statistics
+    void setPortfolio (shared_ptr<Portfolio> engines)
+    {
+        portfolio = engines ;
+    }
+
+    // every strategy polls the flag while it works and throws Cancelled
+    // once it is raised; the interpreter stays usable afterwards
+    void setStop (const atomic<bool>* flag)
+    {
+        stop = flag ;
+    }
+
+    // Strategy::Bdd builds into this manager; sharing one manager between
+    // interpreters lets related formulas reuse its nodes and cached results
+    void setBddManager (shared_ptr<BddManager> manager)
+    {
+        releaseBdd() ;
+        bddManager = manager ;
+    }
+
+    bool isValid ()
+    {
+        if (haveAnalysis) {
+            return analysis.valid ;
+        }
+        ProfileScope scope("isValid") ;
+        if (strategy == Strategy::Portfolio) {
+            return race(true) ;
+        }
+        if (strategy == Strategy::Jit && JitEvaluator::supported()) {
+            JitEvaluator jit(store, root) ;
+            jit.setStop(stop) ;
+            return jit.allSet(threads) ;
+        }
+        if (strategy == Strategy::BitSliced || strategy == Strategy::Jit) {
+            return bitSliced().allSet() ;
+        }
+        if (strategy == Strategy::Parallel) {
+            return bitSliced().allSetParallel(threads) ;
+        }
+        if (strategy == Strategy::Cdcl) {
+            return !solveWithCdcl(true) ;
+        }
+        if (strategy == Strategy::LocalSearch) {
+            return !solveWithLocalSearch(true) ;
+        }
+        if (strategy == Strategy::Bdd) {
+            return bdd() == BddManager::True ;
+        }
+        if (strategy == Strategy::GrayCode) {
+            return !grayFind(false) ;
+        }
+        vector<char> assignment(store.symbols.size(), kUnknown) ;
+        evaluations = 0 ;
+        bool valid = tryAllAssignmentsForValidity(0, assignment) ;
+        reportWork(evaluations, evaluations * order.size()) ;
+        return valid ;
+    }
+
+private :
+    unique_ptr<FormulaStore> owned ;
+    const FormulaStore& store ;
+    NodeId root ;
+    Strategy strategy ;
+    unsigned threads ;
+    vector<int> atoms ;     // ids of the atoms occurring in the formula
+    vector<NodeId> order ;  // nodes reachable from root, children first
+    vector<char> values ;   // per-node scratch for evaluate
+    uint64_t evaluations = 0 ; // evaluatePartial calls, for the profiler
+    vector<size_t> coneStart ; // cone of atoms[i] is coneNodes[coneStart[i], coneStart[i + 1])
+    vector<NodeId> coneNodes ;
+    LocalSearchOptions localSearch ;
+    shared_ptr<Portfolio> portfolio ;
+    const atomic<bool>* stop = nullptr ;
+    shared_ptr<BddManager> bddManager ;
+    bool haveBdd = false ;
+    BddManager::Edge bddRoot = BddManager::False ;
+    bool haveAnalysis = false ;
+    Analysis analysis ;
+    bool haveTable = false ;
+    vector<uint64_t> truthTable ;
+    vector<int> tableAtoms ; // symbol id of each truth-table variable
+
+    static void reportWork (uint64_t assignments, uint64_t visits)
+    {
+        Profiler::global().count(Profiler::Assignments, assignments) ;
+        Profiler::global().count(Profiler::NodeVisits, visits) ;
+    }
+
+    map<string, bool> assignmentAt (const BitSlicedEvaluator& evaluator, int64_t index) const
+    {
+        map<string, bool> assignment ;
+        if (index < 0) {
+            return assignment ;
+        }
+        for (size_t k = 0; k < evaluator.atomCount(); k++) {
+            assignment[store.symbols.name(evaluator.atomId(k))] = (index >> k) & 1 ;
+        }
+        return assignment ;
+    }
+
+    // built once, then every query is a constant-time or linear check
+    BddManager::Edge bdd ()
+    {
+        if (!bddManager) {
+            bddManager = make_shared<BddManager>() ;
+        }
+        if (!haveBdd) {
+            bddRoot = bddManager->build(store, root, stop) ;
+            haveBdd = true ;
+        }
+        return bddRoot ;
+    }
+
+    BitSlicedEvaluator bitSliced () const
+    {
+        BitSlicedEvaluator evaluator(store, root) ;
+        evaluator.setStop(stop) ;
+        return evaluator ;
+    }
+
+    // the examples are a path of the BDD, or CDCL models of the formula and
+    // of its negation; the count is countModels(), which uses the BDD here
+    void analyzeWithoutTable ()
+    {
+        if (strategy == Strategy::Bdd) {
+            BddManager::Edge f = bdd() ;
+            analysis.satisfiable = f != BddManager::False ;
+            analysis.valid = f == BddManager::True ;
+            analysis.witness = analysis.satisfiable ? completed(bddManager->anyModel(f)) : map<string, bool>() ;
+            analysis.counterexample = analysis.valid ? map<string, bool>() : completed(bddManager->anyModel(f ^ 1)) ;
+        } else {
+            analysis.witness.clear() ;
+            analysis.counterexample.clear() ;
+            analysis.satisfiable = solveWithCdcl(false, &analysis.witness) ;
+            analysis.valid = !solveWithCdcl(true, &analysis.counterexample) ;
+        }
+        analysis.models = countModels() ;
+        haveAnalysis = true ;
+    }
+
+    // partial assigns every atom of the formula, those it leaves out being false
+    map<string, bool> completed (const map<string, bool>& partial) const
+    {
+        map<string, bool> assignment ;
+        for (int atom : atoms) {
+            assignment[store.symbols.name(atom)] = false ;
+        }
+        for (const auto& entry : partial) {
+            if (assignment.count(entry.first)) {
+                assignment[entry.first] = entry.second ;
+            }
+        }
+        return assignment ;
+    }
+
+    // validity or satisfiability from the first engine of the portfolio to answer
+    bool race (bool validity) ;
+
+    void releaseBdd ()
+    {
+        if (haveBdd) {
+            bddManager->deref(bddRoot) ;
+            haveBdd = false ;
+        }
+    }
+
+    void init ()
+    {
+        atoms = collectAtoms(store, root) ;
+        vector<bool> live = store.reachable(root) ;
+        for (NodeId id = 0; id <= root; id++) {
+            if (live[id]) {
+                order.push_back(id) ;
+            }
+        }
+        values.resize(root + 1) ;
+    }
+
+    // satisfiability of the formula, or of its negation for validity checks;
+    // model, if given, receives the assignment found
+    bool solveWithCdcl (bool negate, map<string, bool>* model = nullptr)
+    {
+        CdclSolver solver ;
+        solver.setStop(stop) ;
+        Cnf cnf = toCnf(store, root, negate) ;
+        loadCnf(solver, cnf) ;
+        bool satisfiable = solver.solve() ;
+        if (satisfiable && model) {
+            map<string, bool> found ;
+            for (int v = 1; v <= cnf.numVars; v++) {
+                if (!cnf.names[v].empty()) {
+                    found[cnf.names[v]] = solver.modelValue(v) ;
+                }
+            }
+            *model = completed(found) ;
+        }
+        return satisfiable ;
+    }
+
+    // local search answers quickly when there is a model; when it runs out
+    // of budget CDCL settles the question on the same CNF
+    bool solveWithLocalSearch (bool negate)
+    {
+        Cnf cnf = toCnf(store, root, negate) ;
+        LocalSearchOptions options = localSearch ;
+        options.threads = threads ;
+        LocalSearch search(cnf) ;
+        search.setStop(stop) ;
+        if (search.solve(options)) {
+            return true ;
+        }
+        CdclSolver solver ;
+        solver.setStop(stop) ;
+        loadCnf(solver, cnf) ;
+        return solver.solve() ;
+    }
+
+    void evaluateNode (NodeId id, const vector<bool>& assignment)
+    {
+        const Node& n = store[id] ;
+        switch (n.kind) {
+            case NodeKind::Atom: values[id] = assignment[n.a] ; break ;
+            case NodeKind::Const: values[id] = (char) n.a ; break ;
+            case NodeKind::Neg: values[id] = !values[n.a] ; break ;
+            case NodeKind::And: values[id] = values[n.a] && values[n.b] ; break ;
+            case NodeKind::Or: values[id] = values[n.a] || values[n.b] ; break ;
+            case NodeKind::Imp: values[id] = !values[n.a] || values[n.b] ; break ;
+        }
+    }
+
+    // assignment is a flat bitset indexed by atom id; one pass over the
+    // nodes in topological order, each distinct subformula evaluated once
+    bool evaluate (const vector<bool>& assignment) 
+    {
+        for (NodeId id : order) {
+            evaluateNode(id, assignment) ;
+        }
+        return values[root] ;
+    } 
+
+    // the cone of an atom is its node and every node above it, sorted so
+    // children come before parents. built on first use of GrayCode
+    void buildCones ()
+    {
+        vector<vector<NodeId> > parents(root + 1) ;
+        for (NodeId id : order) {
+            const Node& n = store[id] ;
+            if (n.kind == NodeKind::Neg) {
+                parents[n.a].push_back(id) ;
+            } else if (n.kind != NodeKind::Atom && n.kind != NodeKind::Const) {
+                parents[n.a].push_back(id) ;
+                if (n.b != n.a) {
+                    parents[n.b].push_back(id) ;
+                }
+            }
+        }
+        vector<NodeId> atomNode(store.symbols.size(), -1) ;
+        for (NodeId id : order) {
+            if (store[id].kind == NodeKind::Atom) {
+                atomNode[store[id].a] = id ;
+            }
+        }
+
+        vector<char> seen(root + 1) ;
+        coneStart.assign(1, 0) ;
+        for (int atom : atoms) {
+            size_t begin = coneNodes.size() ;
+            coneNodes.push_back(atomNode[atom]) ;
+            seen[atomNode[atom]] = true ;
+            for (size_t i = begin; i < coneNodes.size(); i++) {
+                for (NodeId parent : parents[coneNodes[i]]) {
+                    if (!seen[parent]) {
+                        seen[parent] = true ;
+                        coneNodes.push_back(parent) ;
+                    }
+                }
+            }
+            sort(coneNodes.begin() + begin, coneNodes.end()) ;
+            for (size_t i = begin; i < coneNodes.size(); i++) {
+                seen[coneNodes[i]] = false ;
+            }
+            coneStart.push_back(coneNodes.size()) ;
+        }
+    }
+
+    // walks the assignments in Gray-code order, so step k flips only the
+    // atom at the lowest set bit of k and only that atom's cone is
+    // re-evaluated. true as soon as the formula evaluates to target
+    bool grayFind (bool target)
+    {
+        if (atoms.size() > 62) {
+            throw runtime_error("Too many atoms for truth-table enumeration") ;
+        }
+        if (coneStart.empty()) {
+            buildCones() ;
+        }
+        vector<bool> assignment(store.symbols.size()) ;
+        bool found = evaluate(assignment) == target ;
+        uint64_t steps = (uint64_t) 1 << atoms.size() ;
+        uint64_t k = 1 ;
+        uint64_t visits = order.size() ;
+        for (; !found && k < steps; k++) {
+            if ((k & 4095) == 0 && stopRequested(stop)) {
+                throw Cancelled() ;
+            }
+            size_t flip = (size_t) __builtin_ctzll(k) ;
+            assignment[atoms[flip]] = !assignment[atoms[flip]] ;
+            for (size_t i = coneStart[flip]; i < coneStart[flip + 1]; i++) {
+                evaluateNode(coneNodes[i], assignment) ;
+            }
+            visits += coneStart[flip + 1] - coneStart[flip] ;
+            found = (bool) values[root] == target ;
+        }
+        reportWork(k, visits) ;
+        return found ;
+    }
+
+    static const char kUnknown = 2 ;
+
+    // Kleene's strong three-valued logic: atoms not yet assigned are
+    // kUnknown, and a connective is decided as soon as one operand
+    // decides it (false && _, true || _, false => _, _ => true)
+    char evaluatePartial (const vector<char>& assignment)
+    {
+        evaluations++ ;
+        for (NodeId id : order) {
+            const Node& n = store[id] ;
+            switch (n.kind) {
+                case NodeKind::Atom: values[id] = assignment[n.a] ; break ;
+                case NodeKind::Const: values[id] = (char) n.a ; break ;
+                case NodeKind::Neg: values[id] = negate3(values[n.a]) ; break ;
+                case NodeKind::And: values[id] = and3(values[n.a], values[n.b]) ; break ;
+                case NodeKind::Or: values[id] = or3(values[n.a], values[n.b]) ; break ;
+                case NodeKind::Imp: values[id] = or3(negate3(values[n.a]), values[n.b]) ; break ;
+            }
+        }
+        return values[root] ;
+    }
+
+    static char negate3 (char x)
+    {
+        return x == kUnknown ? kUnknown : !x ;
+    }
+
+    static char and3 (char x, char y)
+    {
+        if (x == 0 || y == 0) {
+            return 0 ;
+        }
+        return x == 1 && y == 1 ? 1 : kUnknown ;
+    }
+
+    static char or3 (char x, char y)
+    {
+        if (x == 1 || y == 1) {
+            return 1 ;
+        }
+        return x == 0 && y == 0 ? 0 : kUnknown ;
+    }
+
+    // each level first evaluates the partial assignment and skips the
+    // whole subtree once the value no longer depends on the atoms left.
+    // a full assignment is always decided, so index never runs past atoms
+    bool tryAssignments (size_t index, vector<char>& assignment)
+    {
+        if (stopRequested(stop)) {
+            throw Cancelled() ;
+        }
+        char value = evaluatePartial(assignment) ;
+        if (value != kUnknown) {
+            return value == 1 ;
+        }
+
+        int atom = atoms[index] ;
+        bool found = false ;
+
+        assignment[atom] = 0 ;
+        if (tryAssignments(index + 1, assignment)) {
+            found = true ;
+        } else {
+            assignment[atom] = 1 ;
+            found = tryAssignments(index + 1, assignment) ;
+        }
+
+        assignment[atom] = kUnknown ;
+        return found ;
+    }
+
+    bool tryAllAssignmentsForValidity (size_t index, vector<char>& assignment) 
+    {
+        if (stopRequested(stop)) {
+            throw Cancelled() ;
+        }
+        char value = evaluatePartial(assignment) ;
+        if (value != kUnknown) {
+            return value == 1 ;
+        }
+
+        int atom = atoms[index] ;
+        bool valid = true ;
+
+        assignment[atom] = 0 ;
+        if (!tryAllAssignmentsForValidity(index + 1, assignment)) {
+            valid = false ;
+        } else {
+            assignment[atom] = 1 ;
+            valid = tryAllAssignmentsForValidity(index + 1, assignment) ;
+        }
+
+        assignment[atom] = kUnknown ;
+        return valid ;
+    }
+} ;
+
+const char FormulaInterpreter::kUnknown ;
+
+Strategy strategyFromName (const string& name)
+{
+    if (name == "tt") return Strategy::TruthTable ;
+    if (name == "gray") return Strategy::GrayCode ;
+    if (name == "bits") return Strategy::BitSliced ;
+    if (name == "parallel") return Strategy::Parallel ;
+    if (name == "jit") return Strategy::Jit ;
+    if (name == "cdcl") return Strategy::Cdcl ;
+    if (name == "walksat") return Strategy::LocalSearch ;
+    if (name == "bdd") return Strategy::Bdd ;
+    if (name == "portfolio") return Strategy::Portfolio ;
+    throw invalid_argument("Unknown strategy: " + name) ;
+}
+
+const char* strategyName (Strategy strategy)
+{
+    switch (strategy) {
+        case Strategy::TruthTable: return "tt" ;
+        case Strategy::GrayCode: return "gray" ;
+        case Strategy::BitSliced: return "bits" ;
+        case Strategy::Parallel: return "parallel" ;
+        case Strategy::Jit: return "jit" ;
+        case Strategy::Cdcl: return "cdcl" ;
+        case Strategy::LocalSearch: return "walksat" ;
+        case Strategy::Bdd: return "bdd" ;
+        case Strategy::Portfolio: return "portfolio" ;
+    }
+    return "?" ;
+}
+
+// the engine used when none is asked for: the bit-sliced truth table while
+// it fits, and beyond that the recursive search, which has no atom limit
+Strategy defaultStrategy (const FormulaStore& store, NodeId root)
+{
+    if (collectAtoms(store, root).size() > TruthTableLayout::kMaxAtoms) {
+        return Strategy::TruthTable ;
+    }
+    return Strategy::BitSliced ;
+}
+
+// races several strategies on one question, each on its own thread with
+// its own interpreter. the first engine to answer wins and raises the
+// shared stop flag; the others notice it at their next checkpoint and
+// unwind with Cancelled. an engine that fails (too many atoms for a truth
+// table, say) just drops out of the race. one portfolio may serve many
+// formulas and threads at once; its racer threads are kept between races
+// and it counts per engine how often it raced, how often it won and the
+// time its wins took
+class Portfolio
+{
+public :
+    explicit Portfolio (vector<Strategy> engines = defaultEngines())
+        : engines(engines), stats(engines.size()), idleRacers(0), closing(false) {
+        if (engines.empty()) {
+            throw invalid_argument("Portfolio needs at least one engine") ;
+        }
+        for (Strategy engine : engines) {
+            if (engine == Strategy::Portfolio) {
+                throw invalid_argument("A portfolio cannot race another portfolio") ;
+            }
+        }
+    }
+
+    // a truth-table engine for small formulas, CDCL for large satisfiable
+    // or unsatisfiable ones, and BDDs for the structured ones in between
+    static vector<Strategy> defaultEngines ()
+    {
+        vector<Strategy> engines ;
+        engines.push_back(JitEvaluator::supported() ? Strategy::Jit : Strategy::BitSliced) ;
+        engines.push_back(Strategy::Cdcl) ;
+        engines.push_back(Strategy::Bdd) ;
+        return engines ;
+    }
+
+    // comma-separated strategy names, e.g. "jit,cdcl,bdd"
+    static vector<Strategy> parseEngines (const string& names)
+    {
+        vector<Strategy> engines ;
+        stringstream in(names) ;
+        string name ;
+        while (getline(in, name, ',')) {
+            engines.push_back(strategyFromName(name)) ;
+        }
+        return engines ;
+    }
+
+    ~Portfolio ()
+    {
+        {
+            lock_guard<mutex> guard(racersLock) ;
+            closing = true ;
+        }
+        racersWake.notify_all() ;
+        for (thread& t : racers) {
+            t.join() ;
+        }
+    }
+
+    Portfolio (const Portfolio&) = delete ;
+    Portfolio& operator= (const Portfolio&) = delete ;
+
+    // validity of root if validity is set, otherwise satisfiability. a
+    // raised outer flag, polled every millisecond while the engines run,
+    // stops them all and makes the race throw Cancelled; without one the
+    // caller just sleeps until the last engine is done
+    bool solve (const FormulaStore& store, NodeId root, bool validity, const LocalSearchOptions& localSearch,
+                const atomic<bool>* outer = nullptr)
+    {
+        typedef chrono::steady_clock Clock ;
+        Clock::time_point start = Clock::now() ;
+        atomic<bool> stop(false) ;
+        mutex lock ;
+        condition_variable done ;
+        size_t finished = 0 ;
+        int winner = -1 ;
+        bool answer = false ;
+        exception_ptr failure ;
+
+        auto runEngine = [&] (size_t i) {
+            try {
+                if (stop) {
+                    throw Cancelled() ; // decided before this engine got a turn
+                }
+                FormulaInterpreter interpreter(store, root, engines[i]) ;
+                interpreter.setThreads(1) ;
+                interpreter.setLocalSearch(localSearch) ;
+                interpreter.setStop(&stop) ;
+                bool result = validity ? interpreter.isValid() : interpreter.isSatisfiable() ;
+                lock_guard<mutex> guard(lock) ;
+                if (winner < 0) {
+                    winner = (int) i ;
+                    answer = result ;
+                    stop = true ;
+                }
+            } catch (const Cancelled&) {
+                // lost the race
+            } catch (...) {
+                lock_guard<mutex> guard(lock) ;
+                if (!failure) {
+                    failure = current_exception() ;
+                }
+            }
+            lock_guard<mutex> guard(lock) ;
+            finished++ ;
+            done.notify_one() ;
+        } ;
+
+        // the caller races the first engine itself unless it has to watch
+        // the outer flag, which saves a hand-off per race
+        size_t first = outer ? 0 : 1 ;
+        for (size_t i = first; i < engines.size(); i++) {
+            launch([&runEngine, i] { runEngine(i) ; }) ;
+        }
+        if (first == 1) {
+            runEngine(0) ;
+        }
+        {
+            unique_lock<mutex> guard(lock) ;
+            if (!outer) {
+                done.wait(guard, [&] { return finished == engines.size() ; }) ;
+            }
+            while (finished < engines.size()) {
+                if (stopRequested(outer)) {
+                    stop = true ;
+                }
+                done.wait_for(guard, chrono::milliseconds(1)) ;
+            }
+        }
+
+        uint64_t elapsed = (uint64_t) chrono::duration_cast<chrono::nanoseconds>(Clock::now() - start).count() ;
+        {
+            lock_guard<mutex> guard(statsLock) ;
+            for (Stats& s : stats) {
+                s.races++ ;
+            }
+            if (winner >= 0) {
+                stats[winner].wins++ ;
+                stats[winner].winNs += elapsed ;
+            }
+        }
+        if (winner < 0) {
+            if (!failure || stopRequested(outer)) {
+                throw Cancelled() ;
+            }
+            rethrow_exception(failure) ;
+        }
+        return answer ;
+    }
+
+    // {"portfolio": [{"engine": "cdcl", "races": 10, "wins": 7, "win_ns": 123}, ...]}
+    void writeJson (ostream& out) const
+    {
+        lock_guard<mutex> guard(statsLock) ;
+        out << "{\"portfolio\": [" ;
+        for (size_t i = 0; i < engines.size(); i++) {
+            out << (i ? ", " : "") << "{\"engine\": \"" << strategyName(engines[i])
+                << "\", \"races\": " << stats[i].races << ", \"wins\": " << stats[i].wins
+                << ", \"win_ns\": " << stats[i].winNs << "}" ;
+        }
+        out << "]}" << endl ;
+    }
+
+private :
+    struct Stats {
+        uint64_t races = 0 ;
+        uint64_t wins = 0 ;
+        uint64_t winNs = 0 ; // wall time of the races this engine won
+    } ;
+
+    vector<Strategy> engines ;
+    vector<Stats> stats ;
+    mutable mutex statsLock ;
+
+    // racer threads, started as races need them and parked between races
+    mutex racersLock ;
+    condition_variable racersWake ;
+    vector<thread> racers ;
+    deque<function<void ()> > pending ; // engine runs no racer has taken yet
+    size_t idleRacers ;
+    bool closing ;
+
+    // hands task to a parked racer, starting one if all are busy
+    void launch (function<void ()> task)
+    {
+        lock_guard<mutex> guard(racersLock) ;
+        pending.push_back(move(task)) ;
+        if (idleRacers < pending.size()) {
+            racers.push_back(thread(&Portfolio::serve, this)) ;
+        }
+        racersWake.notify_one() ;
+    }
+
+    void serve ()
+    {
+        unique_lock<mutex> guard(racersLock) ;
+        for (;;) {
+            idleRacers++ ;
+            racersWake.wait(guard, [this] { return closing || !pending.empty() ; }) ;
+            idleRacers-- ;
+            if (pending.empty()) {
+                return ;
+            }
+            function<void ()> task = move(pending.front()) ;
+            pending.pop_front() ;
+            guard.unlock() ;
+            task() ;
+            guard.lock() ;
+        }
+    }
+} ;
+
+bool FormulaInterpreter::race (bool validity)
+{
+    if (!portfolio) {
+        portfolio = make_shared<Portfolio>() ;
+    }
+    return portfolio->solve(store, root, validity, localSearch, stop) ;
+}
+
+// outcome of comparing two formulas; counterexample assigns every atom of
+// either formula and tells them apart, it is empty when they are equivalent
+struct Equivalence
+{
+    bool equivalent ;
+    map<string, bool> counterexample ;
+} ;
+
+// f and g are equivalent iff their miter (f && !g) || (!f && g) is
+// unsatisfiable. the miter is built in the store that holds both, so
+// hash-consing gives every subterm they share a single node and each
+// backend evaluates it once. formulas with few atoms are settled by one
+// pass over the truth table, larger ones by CDCL on the Tseitin CNF
+Equivalence areEquivalent (FormulaStore& store, NodeId f, NodeId g)
+{
+    static const size_t kTruthTableAtoms = 20 ;
+
+    Equivalence result = { true, map<string, bool>() } ;
+    if (f == g) {
+        return result ;
+    }
+    NodeId miter = simplify(store, store.bin(BinOp::Or,
+        store.bin(BinOp::And, f, store.neg(g)), store.bin(BinOp::And, store.neg(f), g))) ;
+
+    map<string, bool> differing ;
+    if (collectAtoms(store, miter).size() <= kTruthTableAtoms) {
+        Analysis analysis = FormulaInterpreter(store, miter, Strategy::BitSliced).analyze() ;
+        result.equivalent = !analysis.satisfiable ;
+        differing = analysis.witness ;
+    } else {
+        Cnf cnf = toCnf(store, miter) ;
+        CdclSolver solver ;
+        loadCnf(solver, cnf) ;
+        result.equivalent = !solver.solve() ;
+        for (int v = 1; !result.equivalent && v <= cnf.numVars; v++) {
+            if (!cnf.names[v].empty()) {
+                differing[cnf.names[v]] = solver.modelValue(v) ;
+            }
+        }
+    }
+
+    // atoms the simplified miter no longer mentions can take any value
+    if (!result.equivalent) {
+        for (NodeId root : { f, g }) {
+            for (int atom : collectAtoms(store, root)) {
+                result.counterexample[store.symbols.name(atom)] = false ;
+            }
+        }
+        for (const auto& entry : differing) {
+            result.counterexample[entry.first] = entry.second ;
+        }
+    }
+    return result ;
+}
+
+Equivalence areEquivalent (const shared_ptr<Formula>& f, const shared_ptr<Formula>& g)
+{
+    FormulaStore store ;
+    NodeId left = store.intern(f) ;
+    NodeId right = store.intern(g) ;
+    return areEquivalent(store, left, right) ;
+}
+
+// fixed-capacity queue between the batch reader and its workers
+template <typename T>
+class BoundedQueue
+{
+public :
+    BoundedQueue (size_t capacity) : capacity(capacity), closed(false) {}
+
+    void push (T item)
+    {
+        unique_lock<mutex> guard(lock) ;
+        notFull.wait(guard, [this] { return items.size() < capacity ; }) ;
+        items.push_back(move(item)) ;
+        notEmpty.notify_one() ;
+    }
+
+    // false once the queue is closed and drained
+    bool pop (T& item)
+    {
+        unique_lock<mutex> guard(lock) ;
+        notEmpty.wait(guard, [this] { return !items.empty() || closed ; }) ;
+        if (items.empty()) {
+            return false ;
+        }
+        item = move(items.front()) ;
+        items.pop_front() ;
+        notFull.notify_one() ;
+        return true ;
+    }
+
+    void close ()
+    {
+        lock_guard<mutex> guard(lock) ;
+        closed = true ;
+        notEmpty.notify_all() ;
+    }
+
+private :
+    size_t capacity ;
+    bool closed ;
+    deque<T> items ;
+    mutex lock ;
+    condition_variable notFull ;
+    condition_variable notEmpty ;
+} ;
+
+// solves one formula per input line on `jobs` worker threads. each result
+// line is "<line number> <sat|unsat> <valid|invalid>", or "<line number>
+// error <message>"; blank lines are skipped. ordered output holds finished
+// results back until every earlier line has been printed, otherwise lines
+// are printed as they complete
+class BatchRunner
+{
+public :
+    BatchRunner (unsigned jobs, bool ordered, Strategy strategy)
+        : jobs(jobs == 0 ? 1 : jobs), ordered(ordered), strategy(strategy), queue(4 * this->jobs),
+          nextToPrint(0), window(1024 * this->jobs) {}
+
+    // budget of Strategy::LocalSearch, also passed on to portfolio racers
+    void setLocalSearch (const LocalSearchOptions& options)
+    {
+        localSearch = options ;
+    }
+
+    // pick defaultStrategy() per formula instead of the fixed strategy
+    void setDefaultStrategy (bool perFormula)
+    {
+        defaultPerFormula = perFormula ;
+    }
+
+    // one portfolio shared by every worker under Strategy::Portfolio
+    void setPortfolio (shared_ptr<Portfolio> engines)
+    {
+        portfolio = engines ;
+    }
+
+    void run (istream& in, ostream& out)
+    {
+        vector<thread> workers ;
+        for (unsigned i = 0; i < jobs; i++) {
+            workers.push_back(thread(&BatchRunner::work, this, ref(out))) ;
+        }
+
+        string line ;
+        size_t lineNumber = 0 ;
+        size_t index = 0 ;
+        while (getline(in, line)) {
+            lineNumber++ ;
+            if (line.find_first_not_of(" \t\r") == string::npos) {
+                continue ;
+            }
+            if (ordered) {
+                // bound the results held back behind a slow formula
+                unique_lock<mutex> guard(outputLock) ;
+                printed.wait(guard, [&] { return index - nextToPrint < window ; }) ;
+            }
+            Job job = { index++, lineNumber, line } ;
+            queue.push(move(job)) ;
+        }
+        queue.close() ;
+
+        for (thread& t : workers) {
+            t.join() ;
+        }
+        out.flush() ;
+    }
+
+private :
+    struct Job {
+        size_t index ;      // position among the non-blank lines
+        size_t lineNumber ;
+        string text ;
+    } ;
+
+    unsigned jobs ;
+    bool ordered ;
+    Strategy strategy ;
+    bool defaultPerFormula = false ;
+    LocalSearchOptions localSearch ;
+    shared_ptr<Portfolio> portfolio ;
+    BoundedQueue<Job> queue ;
+    mutex outputLock ;
+    condition_variable printed ;
+    size_t nextToPrint ;
+    size_t window ;
+    map<size_t, string> pending ; // finished results waiting for earlier lines
+
+    void work (ostream& out)
+    {
+        Job job ;
+        while (queue.pop(job)) {
+            string result = std::to_string(job.lineNumber) + " " + solve(job.text) + "\n" ;
+
+            lock_guard<mutex> guard(outputLock) ;
+            if (!ordered) {
+                out << result ;
+                continue ;
+            }
+            pending[job.index] = result ;
+            while (!pending.empty() && pending.begin()->first == nextToPrint) {
+                out << pending.begin()->second ;
+                pending.erase(pending.begin()) ;
+                nextToPrint++ ;
+            }
+            printed.notify_all() ;
+        }
+    }
+
+    string solve (const string& text)
+    {
+        try {
+            FormulaStore store ;
+            NodeId formula = simplify(store, parseFormula(text, store)) ;
+            FormulaInterpreter interpreter(store, formula, defaultPerFormula ? defaultStrategy(store, formula) : strategy) ;
+            interpreter.setThreads(1) ; // the batch is already parallel across formulas
+            interpreter.setLocalSearch(localSearch) ;
+            interpreter.setPortfolio(portfolio) ;
+            bool satisfiable = interpreter.isSatisfiable() ;
+            bool valid = satisfiable && interpreter.isValid() ;
+            return string(satisfiable ? "sat" : "unsat") + " " + (valid ? "valid" : "invalid") ;
+        } catch (const exception& e) {
+            return string("error ") + e.what() ;
+        }
+    }
+} ;
+
+// settings for random formulas: atoms are named x0 .. x<atoms-1>, every
+// branch reaches exactly `depth` levels, the weights pick the connective
+// of each inner node, and with probability share an inner node reuses a
+// subterm generated earlier instead of a fresh one
+struct GeneratorOptions
+{
+    int atoms = 12 ;
+    int depth = 8 ;
+    int andWeight = 3 ;
+    int orWeight = 3 ;
+    int impWeight = 1 ;
+    int negWeight = 2 ;
+    double share = 0.2 ;
+    uint64_t seed = 1 ;
+} ;
+
+// writes formulas in the pAnd(pAtom("x0"), ...) input syntax, so they go
+// through the same tokenizer and parsers as real input. reused subterms
+// are repeated in the text and merged again by the store's hash-consing
+class RandomFormulaGenerator
+{
+public :
+    explicit RandomFormulaGenerator (const GeneratorOptions& options)
+        : options(options), rng(options.seed), pool(options.depth + 1) {
+        if (options.atoms < 1 || options.depth < 0) {
+            throw invalid_argument("The generator needs at least one atom and a non-negative depth") ;
+        }
+    }
+
+    string next ()
+    {
+        for (vector<string>& level : pool) {
+            level.clear() ;
+        }
+        return generate(options.depth) ;
+    }
+
+private :
+    GeneratorOptions options ;
+    mt19937_64 rng ;
+    vector<vector<string> > pool ; // subterms of the current formula by height
+
+    bool chance (double p) {
+        return uniform_real_distribution<double>(0, 1)(rng) < p ;
+    }
+
+    int below (int n) {
+        return (int) uniform_int_distribution<int>(0, n - 1)(rng) ;
+    }
+
+    string generate (int height) {
+        if (height == 0) {
+            return "pAtom(\"x" + std::to_string(below(options.atoms)) + "\")" ;
+        }
+        if (!pool[height - 1].empty() && chance(options.share)) {
+            const vector<string>& level = pool[height - 1] ;
+            return level[below((int) level.size())] ;
+        }
+
+        int total = options.andWeight + options.orWeight + options.impWeight + options.negWeight ;
+        int pick = below(max(total, 1)) ;
+        string text ;
+        if (pick < options.negWeight) {
+            text = "pNeg(" + generate(height - 1) + ")" ;
+        } else {
+            pick -= options.negWeight ;
+            const char* op = pick < options.andWeight ? "pAnd"
+                : pick < options.andWeight + options.orWeight ? "pOr" : "pImp" ;
+            string left = generate(height - 1) ;
+            text = string(op) + "(" + left + ", " + generate(height - 1) + ")" ;
+        }
+        pool[height].push_back(text) ;
+        return text ;
+    }
+} ;
+
+// times each stage of the pipeline on its own over a fixed set of random
+// formulas. a stage is repeated over the whole set until it has run for at
+// least 100ms. assignments/s counts the 2^n assignments of every formula
+// whether or not an early exit skipped them, so it compares strategies by
+// how fast they cover the space. prints one JSON object
+int runBenchmark (const GeneratorOptions& options, int formulas, Strategy strategy)
+{
+    RandomFormulaGenerator generator(options) ;
+    vector<string> texts ;
+    for (int i = 0; i < formulas; i++) {
+        texts.push_back(generator.next()) ;
+    }
+    vector<vector<string> > tokens ;
+    FormulaStore store ;
+    vector<NodeId> roots ;
+    double assignments = 0 ;
+    for (const string& text : texts) {
+        tokens.push_back(tokenize(text)) ;
+        roots.push_back(buildFromTokens(tokens.back(), store)) ;
+        assignments += ldexp(1.0, (int) collectAtoms(store, roots.back()).size()) ;
+    }
+
+    cout << "{\"seed\": " << options.seed << ", \"atoms\": " << options.atoms
+         << ", \"depth\": " << options.depth << ", \"share\": " << options.share
+         << ", \"mix\": [" << options.andWeight << ", " << options.orWeight << ", "
+         << options.impWeight << ", " << options.negWeight << "], \"formulas\": " << formulas
+         << ", \"nodes\": " << store.size() << ", \"phases\": [" ;
+
+    size_t trueResults = 0 ;
+    auto measure = [&] (const char* phase, bool solving, function<void (size_t)> body) {
+        typedef chrono::steady_clock Clock ;
+        Clock::time_point start = Clock::now() ;
+        double elapsed = 0 ;
+        size_t passes = 0 ;
+        trueResults = 0 ;
+        do {
+            for (size_t i = 0; i < texts.size(); i++) {
+                body(i) ;
+            }
+            passes++ ;
+            elapsed = chrono::duration<double>(Clock::now() - start).count() ;
+        } while (elapsed < 0.1) ;
+
+        double ops = (double) passes * texts.size() ;
+        cout << (strcmp(phase, "tokenize") == 0 ? "" : ", ") << "\n  {\"phase\": \"" << phase
+             << "\", \"ops\": " << (uint64_t) ops << ", \"ns_per_op\": " << elapsed * 1e9 / ops ;
+        if (solving) {
+            cout << ", \"assignments_per_sec\": " << passes * assignments / elapsed
+                 << ", \"true\": " << trueResults / passes ;
+        }
+        cout << ", \"peak_rss_kb\": " << peakRssKb() << "}" ;
+    } ;
+
+    size_t sink = 0 ;
+    measure("tokenize", false, [&] (size_t i) {
+        sink += tokenize(texts[i]).size() ;
+    }) ;
+    measure("parse", false, [&] (size_t i) {
+        FormulaStore scratch ;
+        sink += buildFromTokens(tokens[i], scratch) ;
+    }) ;
+    measure("atoms", false, [&] (size_t i) {
+        sink += getAllAtomicProps(store, roots[i]).size() ;
+    }) ;
+    measure("satisfiable", true, [&] (size_t i) {
+        FormulaInterpreter interpreter(store, roots[i], strategy) ;
+        trueResults += interpreter.isSatisfiable() ;
+    }) ;
+    measure("valid", true, [&] (size_t i) {
+        FormulaInterpreter interpreter(store, roots[i], strategy) ;
+        trueResults += interpreter.isValid() ;
+    }) ;
+    cout << "\n], \"checksum\": " << sink << "}" << endl ;
+    return 0 ;
+}
+
+// one incremental solver for a whole query file. a line "+ <formula>"
+// adds a permanent constraint, any other line is a query whose formulas,
+// separated by ';', are assumed for that query only. prints the line
+// number and sat, unsat or error per query
+int runQueries (istream& in, ostream& out)
+{
+    IncrementalSolver solver ;
+    string line ;
+    size_t lineNumber = 0 ;
+    while (getline(in, line)) {
+        lineNumber++ ;
+        size_t start = line.find_first_not_of(" \t\r") ;
+        if (start == string::npos) {
+            continue ;
+        }
+        try {
+            if (line[start] == '+') {
+                solver.addConstraint(line.substr(start + 1)) ;
+                continue ;
+            }
+            vector<NodeId> assumed ;
+            stringstream parts(line) ;
+            string part ;
+            while (getline(parts, part, ';')) {
+                assumed.push_back(solver.parse(part)) ;
+            }
+            out << lineNumber << " " << (solver.solve(assumed) ? "sat" : "unsat") << "\n" ;
+        } catch (const exception& e) {
+            out << lineNumber << " error " << e.what() << "\n" ;
+        }
+    }
+    out.flush() ;
+    return 0 ;
+}
+
+// opens path, lets write fill it and makes sure it all reached the file
+void writeFile (const string& path, ios::openmode mode, const function<void (ostream&)>& write)
+{
+    ofstream out(path, mode) ;
+    if (!out) {
+        throw runtime_error("cannot open " + path) ;
+    }
+    write(out) ;
+    out.flush() ;
+    if (!out) {
+        throw runtime_error("cannot write " + path) ;
+    }
+}
+
+// writes the profile when main returns, whichever way it does; to stderr
+// unless a file is given. it runs in a destructor, so a file that cannot
+// be written is reported on stderr rather than thrown
+class ProfileReport
+{
+public :
+    ProfileReport (const string& format, const string& path) : format(format), path(path) {
+        if (!format.empty()) {
+            Profiler::global().enable(format == "trace") ;
+        }
+    }
+
+    ~ProfileReport ()
+    {
+        if (format.empty()) {
+            return ;
+        }
+        ofstream file ;
+        if (!path.empty()) {
+            file.open(path) ;
+            if (!file) {
+                cerr << "cannot open " << path << ", profile not written" << endl ;
+                return ;
+            }
+        }
+        ostream& out = path.empty() ? cerr : file ;
+        if (format == "trace") {
+            Profiler::global().writeTrace(out) ;
+        } else {
+            Profiler::global().writeJson(out) ;
+        }
+        if (!out) {
+            cerr << "cannot write profile to " << path << endl ;
+        }
+    }
+
+private :
+    string format ;
+    string path ;
+} ;
+
+void usage ()
+{
+    cerr << "usage: sat-tt [--strategy tt|gray|bits|parallel|jit|cdcl|walksat|bdd|portfolio] [--count] [--witness] [--no-simplify] [formula]\n"
+         << "       --strategy walksat takes [--flips N] [--seconds S] per worker before falling back to CDCL;\n"
+         << "                                               by default 100 flips per variable (at most 1M) and 1s.\n"
+         << "                                               local search cannot prove unsat, so unsatisfiable\n"
+         << "                                               formulas and valid ones under the validity check\n"
+         << "                                               always spend the whole budget first\n"
+         << "       --strategy portfolio races [--engines a,b,c] (default jit,cdcl,bdd), win counts on stderr\n"
+         << "       sat-tt --file <path>                    read the formula from a text or binary file\n"
+         << "       sat-tt --write-binary <file> | --write-text <file> [formula]\n"
+         << "                                               convert the formula to binary or text\n"
+         << "       sat-tt --batch <file|-> [--jobs N] [--unordered]\n"
+         << "                                               solve one formula per line of a file or stdin\n"
+         << "       sat-tt --queries <file|->              incremental queries: \"+ f\" adds a constraint,\n"
+         << "                                               \"f; g\" asks if f and g can hold with them\n"
+         << "       sat-tt --equivalent <formula> [formula]  check two formulas for equivalence\n"
+         << "       sat-tt --bench [--atoms N] [--depth D] [--mix AND,OR,IMP,NEG] [--share P]\n"
+         << "                      [--seed S] [--formulas K] [--strategy NAME]\n"
+         << "                                               time each stage on random formulas, JSON output\n"
+         << "       add --profile json|trace [--profile-out FILE] to any mode to time its phases\n"
+         << "       sat-tt --dimacs <file.cnf>             solve a DIMACS CNF with the CDCL solver\n"
+         << "       sat-tt --write-dimacs <file> [formula]  write the Tseitin CNF of the formula" << endl ;
+}
+
+void printAssignment (const string& label, bool exists, const map<string, bool>& assignment)
+{
+    if (!exists) {
+        cout << label << ": none" << endl ;
+        return ;
+    }
+    cout << label << ": { " ;
+    for (const auto& entry : assignment) {
+        cout << (entry.second ? "" : "!") << entry.first << " " ;
+    }
+    cout << "}" << endl ;
+}
+
+int solveDimacs (const string& path)
+{
+    ifstream in(path) ;
+    if (!in) {
+        cerr << "cannot open " << path << endl ;
+        return 1 ;
+    }
+    size_t declared = 0 ;
+    Cnf cnf = readDimacs(in, &declared) ;
+    if (cnf.clauses.size() != declared) {
+        cerr << "warning: header declares " << declared << " clauses, read " << cnf.clauses.size() << endl ;
+    }
+    cout << "CNF: " << cnf.numVars << " variables, " << cnf.clauses.size() << " clauses" << endl ;
+
+    CdclSolver solver ;
+    loadCnf(solver, cnf) ;
+    bool satisfiable = solver.solve() ;
+    cout << "CNF is " << (satisfiable ? "satisfiable" : "unsatisfiable") << endl ;
+    return 0 ;
+}
+
+int run (int argc, char* argv[])
+{
+    // this is the input
+    string input = R"(pAnd(pAtom("p"), pOr(pAtom("q"), pNeg(pOr(pNeg(pAtom("r")), pConst("true"))))))" ;
+    string dimacsIn ;
+    string dimacsOut ;
+    string binaryOut ;
+    string textOut ;
+    string inputFile ;
+    string batchInput ;
+    string queryInput ;
+    unsigned jobs = thread::hardware_concurrency() ;
+    bool ordered = true ;
+    bool countModels = false ;
+    bool showExamples = false ;
+    string otherFormula ;
+    bool bench = false ;
+    GeneratorOptions generatorOptions ;
+    int benchFormulas = 100 ;
+    LocalSearchOptions localSearch ;
+    string profileFormat ;
+    string profileOut ;
+    bool simplifyFirst = true ;
+    Strategy strategy = Strategy::BitSliced ;
+    bool strategyGiven = false ;
+    vector<Strategy> engines = Portfolio::defaultEngines() ;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i] ;
+        if (arg == "--dimacs" && i + 1 < argc) {
+            dimacsIn = argv[++i] ;
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batchInput = argv[++i] ;
+        } else if (arg == "--queries" && i + 1 < argc) {
+            queryInput = argv[++i] ;
+        } else if (arg == "--jobs" && i + 1 < argc) {
+            jobs = (unsigned) atoi(argv[++i]) ;
+        } else if (arg == "--unordered") {
+            ordered = false ;
+        } else if (arg == "--count") {
+            countModels = true ;
+        } else if (arg == "--profile" && i + 1 < argc && (string(argv[i + 1]) == "json" || string(argv[i + 1]) == "trace")) {
+            profileFormat = argv[++i] ;
+        } else if (arg == "--profile-out" && i + 1 < argc) {
+            profileOut = argv[++i] ;
+        } else if (arg == "--flips" && i + 1 < argc) {
+            localSearch.maxFlips = strtoull(argv[++i], nullptr, 10) ;
+        } else if (arg == "--seconds" && i + 1 < argc) {
+            localSearch.maxSeconds = atof(argv[++i]) ;
+        } else if (arg == "--bench") {
+            bench = true ;
+        } else if (arg == "--atoms" && i + 1 < argc) {
+            generatorOptions.atoms = atoi(argv[++i]) ;
+        } else if (arg == "--depth" && i + 1 < argc) {
+            generatorOptions.depth = atoi(argv[++i]) ;
+        } else if (arg == "--mix" && i + 1 < argc) {
+            GeneratorOptions& g = generatorOptions ;
+            if (sscanf(argv[++i], "%d,%d,%d,%d", &g.andWeight, &g.orWeight, &g.impWeight, &g.negWeight) != 4) {
+                usage() ;
+                return 1 ;
+            }
+        } else if (arg == "--share" && i + 1 < argc) {
+            generatorOptions.share = atof(argv[++i]) ;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            generatorOptions.seed = strtoull(argv[++i], nullptr, 10) ;
+        } else if (arg == "--formulas" && i + 1 < argc) {
+            benchFormulas = atoi(argv[++i]) ;
+        } else if (arg == "--equivalent" && i + 1 < argc) {
+            otherFormula = argv[++i] ;
+        } else if (arg == "--witness") {
+            showExamples = true ;
+        } else if (arg == "--no-simplify") {
+            simplifyFirst = false ;
+        } else if (arg == "--strategy" && i + 1 < argc) {
+            strategy = strategyFromName(argv[++i]) ;
+            strategyGiven = true ;
+        } else if (arg == "--engines" && i + 1 < argc) {
+            engines = Portfolio::parseEngines(argv[++i]) ;
+        } else if (arg == "--file" && i + 1 < argc) {
+            inputFile = argv[++i] ;
+        } else if (arg == "--write-binary" && i + 1 < argc) {
+            binaryOut = argv[++i] ;
+        } else if (arg == "--write-text" && i + 1 < argc) {
+            textOut = argv[++i] ;
+        } else if (arg == "--write-dimacs" && i + 1 < argc) {
+            dimacsOut = argv[++i] ;
+        } else if (arg[0] == '-') {
+            usage() ;
+            return 1 ;
+        } else {
+            input = arg ;
+        }
+    }
+
+    ProfileReport report(profileFormat, profileOut) ;
+    shared_ptr<Portfolio> portfolio = make_shared<Portfolio>(engines) ;
+
+    if (!dimacsIn.empty()) {
+        return solveDimacs(dimacsIn) ;
+    }
+
+    if (bench) {
+        return runBenchmark(generatorOptions, benchFormulas, strategy) ;
+    }
+
+    if (!queryInput.empty()) {
+        if (queryInput == "-") {
+            return runQueries(cin, cout) ;
+        }
+        ifstream in(queryInput) ;
+        if (!in) {
+            cerr << "cannot open " << queryInput << endl ;
+            return 1 ;
+        }
+        return runQueries(in, cout) ;
+    }
+
+    if (!batchInput.empty()) {
+        BatchRunner runner(jobs, ordered, strategy) ;
+        runner.setDefaultStrategy(!strategyGiven) ;
+        runner.setLocalSearch(localSearch) ;
+        runner.setPortfolio(portfolio) ;
+        if (batchInput == "-") {
+            runner.run(cin, cout) ;
+        } else {
+            ifstream in(batchInput) ;
+            if (!in) {
+                cerr << "cannot open " << batchInput << endl ;
+                return 1 ;
+            }
+            runner.run(in, cout) ;
+        }
+        if (strategy == Strategy::Portfolio) {
+            portfolio->writeJson(cerr) ;
+        }
+        return 0 ;
+    }
+    
+    // get formula from the AST object
+    FormulaStore store ;
+    NodeId formula = inputFile.empty() ? parseFormula(input, store) : parseFile(inputFile, store) ;
+    cout << "Parsed formula: " << store.to_string(formula) << endl ;
+
+    if (!binaryOut.empty()) {
+        writeFile(binaryOut, ios::binary, [&] (ostream& out) {
+            writeBinary(out, store, formula) ;
+        }) ;
+        cout << "Wrote binary formula to " << binaryOut << endl ;
+    }
+    if (!textOut.empty()) {
+        writeFile(textOut, ios::out, [&] (ostream& out) {
+            out << store.to_source(formula) << "\n" ;
+        }) ;
+        cout << "Wrote formula text to " << textOut << endl ;
+    }
+
+    if (simplifyFirst) {
+        NodeId simplified = simplify(store, formula) ;
+        if (simplified != formula) {
+            formula = simplified ;
+            cout << "Simplified formula: " << store.to_string(formula) << endl ;
+        }
+    }
+
+    // get the set of atomic propositions from the formula 
+    set<string> atomSet = getAllAtomicProps(store, formula) ;    
+    cout << "Atoms: { " ;
+    for (const string& atom : atomSet) {
+        cout << atom << " " ;
+    }
+    cout << "}" << endl ;
+
+    if (!dimacsOut.empty()) {
+        writeFile(dimacsOut, ios::out, [&] (ostream& out) {
+            writeDimacs(out, toCnf(store, formula)) ;
+        }) ;
+        cout << "Wrote Tseitin CNF to " << dimacsOut << endl ;
+    }
+
+    if (!otherFormula.empty()) {
+        Equivalence equivalence = areEquivalent(store, formula, parseFormula(otherFormula, store)) ;
+        cout << "Formulas are " << (equivalence.equivalent ? "equivalent" : "not equivalent") << endl ;
+        printAssignment("Counterexample", !equivalence.equivalent, equivalence.counterexample) ;
+        return 0 ;
+    }
+
+    // truth-table, 64 assignments per word unless another strategy was asked
+    // for or the formula has too many atoms for a table
+    if (!strategyGiven) {
+        strategy = defaultStrategy(store, formula) ;
+    }
+    FormulaInterpreter interpreter(store, formula, strategy) ;
+    interpreter.setLocalSearch(localSearch) ;
+    interpreter.setPortfolio(portfolio) ;
+
+    // the early-exit checks stop at the first deciding chunk; once the
+    // examples are wanted, one full pass over the truth table answers everything
+    if (showExamples) {
+        Analysis analysis = interpreter.analyze() ;
+        cout << "Formula is " << (analysis.satisfiable ? "satisfiable" : "unsatisfiable") << endl ;
+        cout << "Formula is " << (analysis.valid ? "valid" : "not valid") << endl ;
+        if (countModels) {
+            cout << "Models: " << analysis.models.to_string() << " of 2^" << atomSet.size() << endl ;
+        }
+        printAssignment("Witness", analysis.satisfiable, analysis.witness) ;
+        printAssignment("Satisfying cube", analysis.satisfiable, interpreter.satisfyingCube()) ;
+        printAssignment("Counterexample", !analysis.valid, analysis.counterexample) ;
+        return 0 ;
+    }
+
+    bool satisfiable = interpreter.isSatisfiable() ;
+    cout << "Formula is " << (satisfiable ? "satisfiable" : "unsatisfiable") << endl ;
+
+    bool valid = interpreter.isValid() ;
+    cout << "Formula is " << (valid ? "valid" : "not valid") << endl ;
+
+    // counted by the strategy itself, so BDDs count past the truth-table limit
+    if (countModels) {
+        ModelCount models = interpreter.countModels() ;
+        cout << "Models: " << models.to_string() << " of 2^" << atomSet.size() << endl ;
+    }
+
+    if (strategy == Strategy::Portfolio) {
+        portfolio->writeJson(cerr) ;
+    }
+    return 0 ;
+}
+
+// bad input of any kind is reported rather than aborting the program
+int main (int argc, char* argv[])
+{
+    try {
+        return run(argc, argv) ;
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl ;
+        return 1 ;
+    }
+}